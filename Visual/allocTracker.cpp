@@ -0,0 +1,178 @@
+/*
+    This code file contains the allocation tracking declared in allocTracker.h,
+    replacements of the global operator new and delete when built with CHESSTOGO_ALLOC_TRACKING.
+*/
+
+#include "allocTracker.h"
+
+#ifdef CHESSTOGO_ALLOC_TRACKING
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//counts shared by all threads, relaxed as only the totals matter
+std::atomic<std::uint64_t> tracked_allocations{ 0 };
+std::atomic<std::uint64_t> tracked_bytes{ 0 };
+std::atomic<std::uint64_t> tracked_frees{ 0 };
+
+//counts of each thread on its own
+thread_local std::uint64_t thread_allocations = 0;
+thread_local std::uint64_t thread_bytes = 0;
+thread_local std::uint64_t thread_frees = 0;
+
+//count an allocation of some bytes
+void CountAllocation(std::size_t size)
+{
+	tracked_allocations.fetch_add(1, std::memory_order_relaxed);
+	tracked_bytes.fetch_add(size, std::memory_order_relaxed);
+	++thread_allocations;
+	thread_bytes += size;
+}
+
+//count a free of an allocation, not of a null pointer
+void CountFree(void* pointer)
+{
+	if (!pointer) return;
+	tracked_frees.fetch_add(1, std::memory_order_relaxed);
+	++thread_frees;
+}
+
+//aligned allocation of some bytes, null if it fails
+void* AlignedAllocate(std::size_t size, std::size_t alignment)
+{
+#ifdef _MSC_VER
+	return _aligned_malloc(size, alignment);
+#else
+	void* pointer = nullptr;
+	return (posix_memalign(&pointer, alignment, size) == 0) ? pointer : nullptr;
+#endif
+}
+
+void AlignedFree(void* pointer)
+{
+#ifdef _MSC_VER
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void* operator new(std::size_t size)
+{
+	CountAllocation(size);
+	auto pointer = std::malloc(size ? size : 1);
+	if (!pointer) throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	CountAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	CountAllocation(size);
+	auto pointer = AlignedAllocate(size ? size : 1, static_cast<std::size_t>(alignment));
+	if (!pointer) throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	CountFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	CountFree(pointer);
+	AlignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+	operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(pointer, alignment);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(pointer, alignment);
+}
+
+//test if this is an allocation tracking build
+bool TracksAllocations()
+{
+	return true;
+}
+
+//allocations of all threads so far
+allocation_count AllocationCount()
+{
+	return allocation_count{ tracked_allocations.load(std::memory_order_relaxed), tracked_bytes.load(std::memory_order_relaxed),
+		tracked_frees.load(std::memory_order_relaxed) };
+}
+
+//allocations of the calling thread so far
+allocation_count ThreadAllocationCount()
+{
+	return allocation_count{ thread_allocations, thread_bytes, thread_frees };
+}
+
+#else
+
+//test if this is an allocation tracking build
+bool TracksAllocations()
+{
+	return false;
+}
+
+//allocations of all threads so far
+allocation_count AllocationCount()
+{
+	return allocation_count{ 0, 0, 0 };
+}
+
+//allocations of the calling thread so far
+allocation_count ThreadAllocationCount()
+{
+	return allocation_count{ 0, 0, 0 };
+}
+
+#endif
@@ -0,0 +1,28 @@
+/*
+    This header file contains the allocation tracking, the global operator new and delete
+    counting every allocation of the program in allocation tracking builds.
+*/
+
+#ifndef _ALLOC_TRACKER_H
+#define _ALLOC_TRACKER_H
+
+#include <cstdint>
+
+//allocations and frees since the program started, bytes as asked of operator new
+struct allocation_count
+{
+	std::uint64_t allocations;
+	std::uint64_t bytes;
+	std::uint64_t frees;
+};
+
+//test if this is an allocation tracking build, the counts stay zero otherwise
+bool TracksAllocations();
+
+//allocations of all threads so far
+allocation_count AllocationCount();
+
+//allocations of the calling thread so far
+allocation_count ThreadAllocationCount();
+
+#endif
@@ -0,0 +1,229 @@
+/*
+    This code file contains the king and pawn against king bitbase declared in bitbase.h,
+    generated by retrograde iteration over every placement with the pawn white and on files a-d,
+    one bit per position telling if white wins.
+*/
+
+#include "bitbase.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+//positions of the bitbase, by side to move, pawn square (files a-d of ranks 2-7), white king and black king
+namespace kpk {
+  const int pawn_squares = 24;
+  const int positions    = 2 * pawn_squares * 64 * 64;
+}
+
+//result of a position while generating
+namespace kpk_state {
+  const unsigned char unknown = 0;
+  const unsigned char invalid = 1;
+  const unsigned char draw    = 2;
+  const unsigned char win     = 3;
+}
+
+//a position of the bitbase, squares are board indexes
+struct kpk_position
+{
+	int color;
+	int white_king;
+	int black_king;
+	int pawn;
+};
+
+//index of a position, the pawn on files a-d of rows 1-6
+auto KPKIndex(int color, int white_king, int black_king, int pawn)
+{
+	auto pawn_code = (pawn / 8 - 1) * 4 + pawn % 8;
+	return (((color == white ? 0 : 1) * kpk::pawn_squares + pawn_code) * 64 + white_king) * 64 + black_king;
+}
+
+//position of an index
+auto KPKPosition(int index)
+{
+	auto pawn_code = (index >> 12) % kpk::pawn_squares;
+	return kpk_position{ index < kpk::positions / 2 ? white : black, (index >> 6) & 63, index & 63,
+		(pawn_code / 4 + 1) * 8 + pawn_code % 4 };
+}
+
+//king steps between two board indexes
+auto KPKDistance(int index1, int index2)
+{
+	return std::max(std::abs(index1 / 8 - index2 / 8), std::abs(index1 % 8 - index2 % 8));
+}
+
+//test if the white pawn attacks a board index, white pawns move to lower rows
+auto KPKPawnAttacks(int pawn, int index)
+{
+	return index / 8 == pawn / 8 - 1 && std::abs(index % 8 - pawn % 8) == 1;
+}
+
+//call visit with every square a king steps to from a board index
+template<typename Visit>
+auto KPKKingSteps(int index, const Visit& visit)
+{
+	for (auto row = std::max(index / 8 - 1, 0); row <= std::min(index / 8 + 1, 7); ++row)
+	{
+		for (auto column = std::max(index % 8 - 1, 0); column <= std::min(index % 8 + 1, 7); ++column)
+		{
+			if (row * 8 + column != index) visit(row * 8 + column);
+		}
+	}
+}
+
+//result of a position without looking at the positions after it: illegal placements, promotions black can not stop,
+//and black to move mated, stalemated or taking the pawn
+auto KPKInitial(const kpk_position& pos)
+{
+	if (KPKDistance(pos.white_king, pos.black_king) <= 1 || pos.white_king == pos.pawn || pos.black_king == pos.pawn)
+	{
+		return kpk_state::invalid;
+	}
+	if (pos.color == white)
+	{
+		if (KPKPawnAttacks(pos.pawn, pos.black_king)) return kpk_state::invalid;
+		auto promotion = pos.pawn - 8;
+		if (pos.pawn / 8 == 1 && promotion != pos.white_king && promotion != pos.black_king
+			&& (KPKDistance(pos.black_king, promotion) > 1 || KPKDistance(pos.white_king, promotion) == 1))
+		{
+			//the new queen can not be taken
+			return kpk_state::win;
+		}
+		return kpk_state::unknown;
+	}
+	auto moves = false;
+	auto takes = false;
+	KPKKingSteps(pos.black_king, [&](int to)
+		{
+			if (KPKDistance(to, pos.white_king) <= 1 || KPKPawnAttacks(pos.pawn, to)) return;
+			moves = true;
+			takes = takes || to == pos.pawn;
+		});
+	if (takes) return kpk_state::draw;
+	if (!moves) return KPKPawnAttacks(pos.pawn, pos.black_king) ? kpk_state::win : kpk_state::draw;
+	return kpk_state::unknown;
+}
+
+//result of a position from the positions after its moves, white wins if any move wins and black draws if any move draws,
+//unknown while neither is settled
+auto KPKFromMoves(const std::vector<unsigned char>& states, const kpk_position& pos)
+{
+	auto good = (pos.color == white) ? kpk_state::win : kpk_state::draw;
+	auto bad = (pos.color == white) ? kpk_state::draw : kpk_state::win;
+	auto result = bad;
+	auto visit = [&](unsigned char state)
+		{
+			if (state == good) result = good;
+			else if (state != bad && result == bad) result = kpk_state::unknown;
+		};
+	if (pos.color == white)
+	{
+		KPKKingSteps(pos.white_king, [&](int to)
+			{
+				if (to == pos.pawn || KPKDistance(to, pos.black_king) <= 1) return;
+				visit(states[KPKIndex(black, to, pos.black_king, pos.pawn)]);
+			});
+		auto push = pos.pawn - 8;
+		if (push != pos.white_king && push != pos.black_king)
+		{
+			//a promotion that does not win at once loses the queen
+			visit(pos.pawn / 8 == 1 ? kpk_state::draw : states[KPKIndex(black, pos.white_king, pos.black_king, push)]);
+			if (pos.pawn / 8 == 6 && push - 8 != pos.white_king && push - 8 != pos.black_king)
+			{
+				visit(states[KPKIndex(black, pos.white_king, pos.black_king, push - 8)]);
+			}
+		}
+	}
+	else
+	{
+		KPKKingSteps(pos.black_king, [&](int to)
+			{
+				if (KPKDistance(to, pos.white_king) <= 1 || KPKPawnAttacks(pos.pawn, to)) return;
+				visit(states[KPKIndex(white, pos.white_king, to, pos.pawn)]);
+			});
+	}
+	return result;
+}
+
+//retrograde iteration until no position changes, what is still unknown then is a draw white can not force a win of,
+//kept as one bit of white wins per position
+auto MakeKPKBitbase()
+{
+	auto states = std::vector<unsigned char>(kpk::positions);
+	for (auto index = 0; index < kpk::positions; ++index) states[index] = KPKInitial(KPKPosition(index));
+	auto changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (auto index = 0; index < kpk::positions; ++index)
+		{
+			if (states[index] != kpk_state::unknown) continue;
+			states[index] = KPKFromMoves(states, KPKPosition(index));
+			changed = changed || states[index] != kpk_state::unknown;
+		}
+	}
+	auto wins = std::vector<std::uint64_t>(kpk::positions / 64);
+	for (auto index = 0; index < kpk::positions; ++index)
+	{
+		if (states[index] == kpk_state::win) wins[index / 64] |= std::uint64_t{ 1 } << (index % 64);
+	}
+	return wins;
+}
+const auto kpk_wins = MakeKPKBitbase();
+
+//win/draw/loss of a king and pawn against king board for the color to move, the board turned so the pawn
+//is white and on files a-d
+bool ProbeKPK(const board& brd, int color, int& result)
+{
+	auto white_king = -1;
+	auto black_king = -1;
+	auto pawn = -1;
+	auto strong = white;
+	for (auto index = 0; index < 64; ++index)
+	{
+		switch (brd[index])
+		{
+		case ' ':
+			break;
+		case 'K':
+			white_king = index;
+			break;
+		case 'k':
+			black_king = index;
+			break;
+		case 'P':
+		case 'p':
+			if (pawn >= 0) return false;
+			pawn = index;
+			strong = (brd[index] == 'P') ? white : black;
+			break;
+		default:
+			return false;
+		}
+	}
+	if (pawn < 0 || white_king < 0 || black_king < 0) return false;
+	if (pawn / 8 == 0 || pawn / 8 == 7)
+	{
+		//a pawn on the first or last row is no position of the bitbase, only a fen can set one there
+		return false;
+	}
+	if (strong == black)
+	{
+		//flip the rows and swap the colors
+		std::swap(white_king, black_king);
+		white_king ^= 56;
+		black_king ^= 56;
+		pawn ^= 56;
+	}
+	if (pawn % 8 > 3)
+	{
+		white_king ^= 7;
+		black_king ^= 7;
+		pawn ^= 7;
+	}
+	auto index = KPKIndex(color * strong, white_king, black_king, pawn);
+	if (((kpk_wins[index / 64] >> (index % 64)) & 1) == 0) result = wdl::draw;
+	else result = (color == strong) ? wdl::win : wdl::loss;
+	return true;
+}
@@ -0,0 +1,16 @@
+/*
+    This header file contains the king and pawn against king bitbase,
+    exact win/draw results of every such board, built in memory once at startup.
+*/
+
+#ifndef _BITBASE_H
+#define _BITBASE_H
+
+#include "engine.h"
+#include "tablebase.h"
+
+//win/draw/loss (wdl::win, wdl::draw or wdl::loss) of a king and pawn against king board for the color to move,
+//false if the board has any other material
+bool ProbeKPK(const board& brd, int color, int& result);
+
+#endif
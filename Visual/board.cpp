@@ -3,6 +3,7 @@
 */
 
 #include "board.h"
+#include "traceEvents.h"
 
 Board::Board(sf::Color col1, sf::Color col2){
     load(col1,col2);
@@ -27,6 +28,7 @@ void Board::load(sf::Color col1, sf::Color col2){
 
 // Draw class on SFML Window
 void Board::draw(sf::RenderTarget& target, sf::RenderStates states) const{
+    trace_scope trace("Board::draw");
     for(int i=0;i<64;i++){
         target.draw(m_boardSquares[i]);
     }
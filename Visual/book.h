@@ -0,0 +1,46 @@
+/*
+    This header file contains the opening book,
+    polyglot book files memory mapped and searched by the polyglot key of a board.
+*/
+
+#ifndef _BOOK_H
+#define _BOOK_H
+
+#include <cstdint>
+#include <string>
+#include "engine.h"
+
+//polyglot book entry layout, big endian, sorted by key:
+//  uint64      key
+//  uint16      move, to file and row in bits 0-5, from file and row in bits 6-11, promotion nbrq 1-4 in bits 12-14
+//  uint16      weight
+//  uint32      learn
+namespace polyglot {
+  const int entry_size = 16;
+}
+
+//polyglot key of a board for the color to move, the history is the boards played up to it,
+//castling rights last while the king and rook stay on their squares in all of them,
+//and the en passant file counts after a double pawn step when a pawn can take it
+std::uint64_t PolyglotKey(const board& brd, int color, const boards& history);
+
+//polyglot move between board indexes, promotion is the piece promoted to or ' ', castling is the king taking its own rook
+std::uint16_t PolyglotMove(int from, int to, char promotion);
+
+//polyglot move of a generated board
+std::uint16_t PolyglotMove(const board& brd, const score_board& sbrd);
+
+//uci name of a polyglot move of a board, like "e2e4", "e7e8q" or "e1g1" for castling
+std::string PolyglotMoveName(const board& brd, std::uint16_t move);
+
+//play from the polyglot book file of a path, an empty path for none, false if it can not be mapped,
+//not while searching
+bool LoadBook(const std::string& path);
+
+//how widely book moves are picked, 0 only the heaviest up to 100 any in proportion to its weight
+void SetBookVariety(int variety);
+
+//a book move for a board among its generated boards, picked by weight, false if the board is not in the book
+bool BookMove(const board& brd, int color, const boards& history, const score_boards& next_boards, board& move);
+
+#endif
@@ -0,0 +1,338 @@
+/*
+    This code file contains the opening book builder, the games of pgn files counted move by move
+    into a polyglot book (see book.h), in bounded memory by spilling sorted runs to disk.
+*/
+
+#include "book.h"
+#include "mappedFile.h"
+#include "pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+//builder parameters, the shards split the keys by their top bits so the shards in order are the keys in order
+namespace bookgen {
+  const int default_plies     = 30;
+  const int default_min_games = 2;
+  const int default_memory_mb = 1024;
+  const int shard_bits        = 6;
+  const int shards            = 1 << shard_bits;
+  const std::size_t batch     = 1 << 12;
+  const std::size_t chunk     = 1 << 20;
+  const int entry_bytes       = 64;
+  const int max_weight        = 0xFFFF;
+}
+
+//a move of a position and the results of the games it was played in, for the side that played it
+struct move_count
+{
+	std::uint64_t key;
+	std::uint16_t move;
+	std::uint32_t wins;
+	std::uint32_t draws;
+	std::uint32_t losses;
+};
+
+//book order, by key then move
+auto CountBefore(const move_count& count1, const move_count& count2)
+{
+	return count1.key < count2.key || (count1.key == count2.key && count1.move < count2.move);
+}
+
+//key of the counts map, the position key and move
+struct count_key
+{
+	std::uint64_t key;
+	std::uint16_t move;
+	bool operator==(const count_key& other) const { return key == other.key && move == other.move; }
+};
+struct count_key_hash
+{
+	std::size_t operator()(const count_key& key) const { return static_cast<std::size_t>(key.key ^ (std::uint64_t{ key.move } * 0x9E3779B97F4A7C15)); }
+};
+
+//results of a move
+struct results
+{
+	std::uint32_t wins;
+	std::uint32_t draws;
+	std::uint32_t losses;
+};
+
+//the counts of one range of keys, spilled to sorted run files when they grow past their share of the memory
+struct book_shard
+{
+	std::mutex lock;
+	std::unordered_map<count_key, results, count_key_hash> counts;
+	std::vector<std::string> runs;
+};
+
+//a book being built
+struct book_builder
+{
+	std::string output;
+	int plies;
+	std::size_t shard_entries;
+	std::unique_ptr<book_shard[]> shards{ new book_shard[bookgen::shards] };
+	std::atomic<std::uint64_t> games{ 0 };
+	std::atomic<std::uint64_t> skipped{ 0 };
+	std::atomic<std::uint64_t> illegal{ 0 };
+	std::atomic<std::uint64_t> moves{ 0 };
+	std::atomic<std::uint64_t> spills{ 0 };
+	std::atomic<bool> failed{ false };
+};
+
+//write the counts of a shard as a sorted run file and forget them, under the shard lock
+auto Spill(book_builder& builder, book_shard& shard, int index)
+{
+	auto sorted = std::vector<move_count>{};
+	sorted.reserve(shard.counts.size());
+	for (auto& [key, result] : shard.counts) sorted.push_back(move_count{ key.key, key.move, result.wins, result.draws, result.losses });
+	std::sort(begin(sorted), end(sorted), CountBefore);
+	auto path = builder.output + ".run" + std::to_string(index) + "." + std::to_string(shard.runs.size());
+	auto file = std::ofstream(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(sorted.data()), sorted.size() * sizeof(move_count));
+	if (!file) builder.failed = true;
+	shard.runs.push_back(path);
+	shard.counts = {};
+	++builder.spills;
+}
+
+//add a batch of moves to their shard
+auto AddBatch(book_builder& builder, int index, std::vector<move_count>& batch)
+{
+	auto& shard = builder.shards[index];
+	auto guard = std::lock_guard<std::mutex>(shard.lock);
+	for (auto& count : batch)
+	{
+		auto& result = shard.counts[count_key{ count.key, count.move }];
+		result.wins += count.wins;
+		result.draws += count.draws;
+		result.losses += count.losses;
+	}
+	batch.clear();
+	if (shard.counts.size() > builder.shard_entries) Spill(builder, shard, index);
+}
+
+//count the moves of the games in a range of a pgn text, up to the ply limit, batched by shard
+auto CountGames(book_builder& builder, const char* first, const char* last, std::vector<std::vector<move_count>>& batches)
+{
+	auto position = first;
+	auto game = pgn_game{};
+	while (NextGame(position, last, game))
+	{
+		if (game.result == pgn_result::unknown)
+		{
+			++builder.skipped;
+			continue;
+		}
+		auto played = 0;
+		auto legal = PlayGame(game, builder.plies, [&](const board& brd, int color, const boards& history, const san_move& move)
+			{
+				auto key = PolyglotKey(brd, color, history);
+				auto result = game.result * color;
+				auto index = static_cast<int>(key >> (64 - bookgen::shard_bits));
+				batches[index].push_back(move_count{ key, PolyglotMove(move.from, move.to, move.promotion),
+					std::uint32_t(result > 0), std::uint32_t(result == 0), std::uint32_t(result < 0) });
+				if (batches[index].size() >= bookgen::batch) AddBatch(builder, index, batches[index]);
+				++played;
+			});
+		if (!legal) ++builder.illegal;
+		builder.moves += played;
+		++builder.games;
+	}
+}
+
+//a run file read back in order, a buffer at a time
+struct run_reader
+{
+	std::ifstream file;
+	std::vector<move_count> buffer;
+	std::size_t next = 0;
+
+	explicit run_reader(const std::string& path)
+		: file(path, std::ios::binary)
+	{
+	}
+
+	bool Read(move_count& count)
+	{
+		if (next == buffer.size())
+		{
+			buffer.resize(bookgen::batch);
+			file.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(move_count));
+			buffer.resize(static_cast<std::size_t>(file.gcount()) / sizeof(move_count));
+			next = 0;
+			if (buffer.empty()) return false;
+		}
+		count = buffer[next++];
+		return true;
+	}
+};
+
+//write the book entries of a key, the moves played in enough games weighted two for a win and one for a draw,
+//scaled down to fit, heaviest first
+auto WriteKey(std::ofstream& book, std::vector<move_count>& counts, int min_games, std::uint64_t& entries)
+{
+	auto weights = std::vector<std::pair<std::uint64_t, std::uint16_t>>{};
+	auto heaviest = std::uint64_t{ 0 };
+	for (auto& count : counts)
+	{
+		auto games = std::uint64_t{ count.wins } + count.draws + count.losses;
+		auto weight = std::uint64_t{ count.wins } * 2 + count.draws;
+		if (games < static_cast<std::uint64_t>(min_games) || weight == 0) continue;
+		weights.emplace_back(weight, count.move);
+		heaviest = std::max(heaviest, weight);
+	}
+	std::sort(begin(weights), end(weights), [](const auto& weight1, const auto& weight2)
+		{
+			return weight1.first > weight2.first;
+		});
+	for (auto& [weight, move] : weights)
+	{
+		if (heaviest > bookgen::max_weight) weight = std::max<std::uint64_t>(1, weight * bookgen::max_weight / heaviest);
+		unsigned char entry[polyglot::entry_size] = {};
+		for (auto index = 0; index < 8; ++index) entry[index] = static_cast<unsigned char>(counts[0].key >> (56 - index * 8));
+		entry[8] = static_cast<unsigned char>(move >> 8);
+		entry[9] = static_cast<unsigned char>(move);
+		entry[10] = static_cast<unsigned char>(weight >> 8);
+		entry[11] = static_cast<unsigned char>(weight);
+		book.write(reinterpret_cast<const char*>(entry), polyglot::entry_size);
+		++entries;
+	}
+	counts.clear();
+}
+
+//merge the runs and the counts left in memory of each shard, in shard order, into the book
+auto WriteBook(book_builder& builder, int min_games, std::uint64_t& entries)
+{
+	auto book = std::ofstream(builder.output, std::ios::binary);
+	for (auto index = 0; index < bookgen::shards; ++index)
+	{
+		auto& shard = builder.shards[index];
+		if (!shard.counts.empty()) Spill(builder, shard, index);
+		auto readers = std::vector<std::unique_ptr<run_reader>>{};
+		for (auto& run : shard.runs) readers.push_back(std::make_unique<run_reader>(run));
+
+		//k-way merge, the smallest head of the runs next
+		auto later = [](const auto& head1, const auto& head2)
+			{
+				return CountBefore(head2.first, head1.first);
+			};
+		auto heads = std::priority_queue<std::pair<move_count, std::size_t>, std::vector<std::pair<move_count, std::size_t>>, decltype(later)>(later);
+		auto count = move_count{};
+		for (auto reader = std::size_t{ 0 }; reader < readers.size(); ++reader)
+		{
+			if (readers[reader]->Read(count)) heads.emplace(count, reader);
+		}
+		auto key_counts = std::vector<move_count>{};
+		while (!heads.empty())
+		{
+			auto [head, reader] = heads.top();
+			heads.pop();
+			if (readers[reader]->Read(count)) heads.emplace(count, reader);
+			if (!key_counts.empty() && key_counts.back().key != head.key) WriteKey(book, key_counts, min_games, entries);
+			if (!key_counts.empty() && key_counts.back().move == head.move)
+			{
+				key_counts.back().wins += head.wins;
+				key_counts.back().draws += head.draws;
+				key_counts.back().losses += head.losses;
+			}
+			else key_counts.push_back(head);
+		}
+		if (!key_counts.empty()) WriteKey(book, key_counts, min_games, entries);
+		readers.clear();
+		for (auto& run : shard.runs) std::remove(run.c_str());
+		shard.runs.clear();
+	}
+	return bool(book);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "usage: chesstogo-bookgen <book.bin> <games.pgn>... [-plies " << bookgen::default_plies << "] [-min "
+			<< bookgen::default_min_games << "] [-memory " << bookgen::default_memory_mb << " mb] [-threads]" << std::endl;
+		return 1;
+	}
+	auto builder = book_builder{};
+	builder.output = argv[1];
+	builder.plies = bookgen::default_plies;
+	auto min_games = bookgen::default_min_games;
+	auto memory_mb = bookgen::default_memory_mb;
+	auto threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	auto inputs = std::vector<std::string>{};
+	for (auto index = 2; index < argc; ++index)
+	{
+		auto option = std::string(argv[index]);
+		auto value = (index + 1 < argc) ? std::atoi(argv[index + 1]) : 0;
+		if (option == "-plies") builder.plies = std::max(1, value);
+		else if (option == "-min") min_games = std::max(1, value);
+		else if (option == "-memory") memory_mb = std::max(1, value);
+		else if (option == "-threads") threads = std::max(1, value);
+		else
+		{
+			inputs.push_back(option);
+			continue;
+		}
+		++index;
+	}
+	builder.shard_entries = (std::size_t(memory_mb) << 20) / bookgen::entry_bytes / bookgen::shards;
+	auto start = std::chrono::steady_clock::now();
+
+	//the games split into chunks at game starts, taken by the threads in turn
+	auto files = std::vector<mapped_file>{};
+	auto chunks = std::vector<std::pair<const char*, const char*>>{};
+	for (auto& input : inputs)
+	{
+		files.emplace_back(input);
+		auto& file = files.back();
+		if (file.empty())
+		{
+			std::cerr << "could not read " << input << std::endl;
+			return 1;
+		}
+		auto first = reinterpret_cast<const char*>(file.data());
+		auto ranges = SplitGames(first, first + file.size(), bookgen::chunk);
+		chunks.insert(end(chunks), begin(ranges), end(ranges));
+	}
+	auto next_chunk = std::atomic<std::size_t>{ 0 };
+	auto Work = [&]()
+		{
+			auto batches = std::vector<std::vector<move_count>>(bookgen::shards);
+			for (auto index = next_chunk++; index < chunks.size(); index = next_chunk++)
+			{
+				CountGames(builder, chunks[index].first, chunks[index].second, batches);
+			}
+			for (auto index = 0; index < bookgen::shards; ++index)
+			{
+				if (!batches[index].empty()) AddBatch(builder, index, batches[index]);
+			}
+		};
+	auto helpers = std::vector<std::thread>{};
+	for (auto thread = 1; thread < threads; ++thread) helpers.emplace_back(Work);
+	Work();
+	for (auto& helper : helpers) helper.join();
+
+	auto entries = std::uint64_t{ 0 };
+	if (!WriteBook(builder, min_games, entries) || builder.failed)
+	{
+		std::cerr << "could not write " << builder.output << std::endl;
+		return 1;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << builder.games << " games (" << builder.skipped << " without a result skipped, " << builder.illegal << " cut short at an illegal move), " << builder.moves << " moves, "
+		<< builder.spills << " runs, " << entries << " book entries in " << builder.output << ", " << elapsed.count() << "s" << std::endl;
+	return 0;
+}
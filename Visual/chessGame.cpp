@@ -3,6 +3,7 @@
 */
 
 #include "chessGame.h"
+#include "traceEvents.h"
 
 
 ChessGame::ChessGame(sf::Color bordCol1 = sf::Color::White, sf::Color bordCol2 = sf::Color::Black)
@@ -320,6 +321,7 @@ bool ChessGame::moveSelected(int pos){
 
 void ChessGame::calcPossibleMoves(){
 
+    trace_scope trace("calcPossibleMoves");
     Piece* tmpPiece;
 
     // LOOP for every piece
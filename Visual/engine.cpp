@@ -0,0 +1,1762 @@
+/*
+    This code file contains the chess engine, board generation,
+    evaluation and search, declared in engine.h
+*/
+
+#include "engine.h"
+#include "engineInternal.h"
+#include "allocTracker.h"
+#include "bitbase.h"
+#include "book.h"
+#include "explorer.h"
+#include "nnue.h"
+#include "perfCounters.h"
+#include "tablebase.h"
+#include "traceEvents.h"
+#include "evaluationMap.h"
+#include <initializer_list>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//piece capture actions, per vector
+const int no_capture   = 0;
+const int may_capture  = 1;
+const int must_capture = 2;
+
+//game phase weight of each piece, the phase counts down from midgame with the pieces taken
+namespace phase_of {
+  const int queen   = 4;
+  const int rook    = 2;
+  const int bishop  = 1;
+  const int knight  = 1;
+  const int midgame = 24;
+}
+
+//midgame and endgame scores packed in one int, the endgame score in the upper 16 bits,
+//so adding or negating packed scores does both at once
+constexpr int PackScore(int midgame, int endgame)
+{
+	return int(unsigned(endgame) << 16) + midgame;
+}
+
+constexpr int MidgameScore(int packed)
+{
+	return std::int16_t(std::uint16_t(unsigned(packed)));
+}
+
+constexpr int EndgameScore(int packed)
+{
+	return std::int16_t(std::uint16_t((unsigned(packed) + 0x8000) >> 16));
+}
+
+//blend the midgame and endgame scores by the game phase
+constexpr int TaperScore(int packed, int phase)
+{
+	phase = std::min(phase, phase_of::midgame);
+	return (MidgameScore(packed) * phase + EndgameScore(packed) * (phase_of::midgame - phase)) / phase_of::midgame;
+}
+
+//pawn structure scores, packed midgame and endgame, passed pawns by their rank counted from their own back rank
+namespace pawn_value_of {
+  const int doubled  = PackScore(-10, -20);
+  const int isolated = PackScore(-10, -15);
+  const int shield   = PackScore(8, 0);
+  const std::array<int, 8> passed = {{
+	PackScore(0, 0), PackScore(5, 10), PackScore(10, 20), PackScore(15, 35),
+	PackScore(25, 55), PackScore(40, 80), PackScore(60, 110), PackScore(0, 0) }};
+}
+
+//vector set of a list, at compile time
+template <typename T>
+constexpr auto MakeSet(std::initializer_list<T> list)
+{
+	auto set = vector_set<T>{};
+	for (auto& item : list) set.items[set.count++] = item;
+	return set;
+}
+
+//map board square contents to piece type/color
+constexpr auto MakePieceTypes()
+{
+	auto types = std::array<int, piece_codes>{};
+	for (auto piece : { 'p', 'r', 'n', 'b', 'k', 'q' }) types[piece] = black;
+	for (auto piece : { 'P', 'R', 'N', 'B', 'K', 'Q' }) types[piece] = white;
+	return types;
+}
+constexpr std::array<int, piece_codes> piece_type = MakePieceTypes();
+
+//piece move vectors and capture actions
+constexpr auto black_pawn_moves = MakeSet<move>({
+	{0, 1, 0, no_capture}, {-1, 1, 1, must_capture}, {1, 1, 1, must_capture} });
+constexpr auto white_pawn_moves = MakeSet<move>({
+	{0, -1, 0, no_capture}, {-1, -1, 1, must_capture}, {1, -1, 1, must_capture} });
+constexpr auto rook_moves = MakeSet<move>({
+	{0, -1, 7, may_capture}, {-1, 0, 7, may_capture}, {0, 1, 7, may_capture}, {1, 0, 7, may_capture} });
+constexpr auto bishop_moves = MakeSet<move>({
+	{-1, -1, 7, may_capture}, {1, 1, 7, may_capture}, {-1, 1, 7, may_capture}, {1, -1, 7, may_capture} });
+constexpr auto knight_moves = MakeSet<move>({
+	{-2, 1, 1, may_capture}, {2, -1, 1, may_capture}, {2, 1, 1, may_capture}, {-2, -1, 1, may_capture},
+	{-1, -2, 1, may_capture}, {-1, 2, 1, may_capture}, {1, -2, 1, may_capture}, {1, 2, 1, may_capture} });
+constexpr auto queen_moves = MakeSet<move>({
+	{0, -1, 7, may_capture}, {-1, 0, 7, may_capture}, {0, 1, 7, may_capture}, {1, 0, 7, may_capture},
+	{-1, -1, 7, may_capture}, {1, 1, 7, may_capture}, {-1, 1, 7, may_capture}, {1, -1, 7, may_capture} });
+constexpr auto king_moves = MakeSet<move>({
+	{0, -1, 1, may_capture}, {-1, 0, 1, may_capture}, {0, 1, 1, may_capture}, {1, 0, 1, may_capture},
+	{-1, -1, 1, may_capture}, {1, 1, 1, may_capture}, {-1, 1, 1, may_capture}, {1, -1, 1, may_capture} });
+
+//map piece to its movement possibilities
+constexpr auto MakeMovesMap()
+{
+	auto map = std::array<moves*, piece_codes>{};
+	map['p'] = &black_pawn_moves; map['P'] = &white_pawn_moves;
+	map['R'] = &rook_moves;       map['r'] = &rook_moves;
+	map['B'] = &bishop_moves;     map['b'] = &bishop_moves;
+	map['N'] = &knight_moves;     map['n'] = &knight_moves;
+	map['Q'] = &queen_moves;      map['q'] = &queen_moves;
+	map['K'] = &king_moves;       map['k'] = &king_moves;
+	return map;
+}
+constexpr std::array<moves*, piece_codes> moves_map = MakeMovesMap();
+
+//piece check vectors, king is tested for being on these vectors for check tests
+constexpr auto black_pawn_vectors = MakeSet<vector>({
+	{-1, 1, 1}, {1, 1, 1} });
+constexpr auto white_pawn_vectors = MakeSet<vector>({
+	{-1, -1, 1}, {1, -1, 1} });
+constexpr auto bishop_vectors = MakeSet<vector>({
+	{-1, -1, 7}, {1, 1, 7}, {-1, 1, 7}, {1, -1, 7} });
+constexpr auto rook_vectors = MakeSet<vector>({
+	{0, -1, 7}, {-1, 0, 7}, {0, 1, 7}, {1, 0, 7} });
+constexpr auto knight_vectors = MakeSet<vector>({
+	{-1, -2, 1}, {-1, 2, 1}, {-2, -1, 1}, {-2, 1, 1}, {1, -2, 1}, {1, 2, 1}, {2, -1, 1}, {2, 1, 1} });
+constexpr auto queen_vectors = MakeSet<vector>({
+	{-1, -1, 7}, {1, 1, 7}, {-1, 1, 7}, {1, -1, 7}, {0, -1, 7}, {-1, 0, 7}, {0, 1, 7}, {1, 0, 7} });
+constexpr auto king_vectors = MakeSet<vector>({
+	{-1, -1, 1}, {1, 1, 1}, {-1, 1, 1}, {1, -1, 1}, {0, -1, 1}, {-1, 0, 1}, {0, 1, 1}, {1, 0, 1} });
+
+//check tests, piece types given can not be on the vectors given
+tests white_tests = {
+	{"qb", &bishop_vectors}, {"qr", &rook_vectors}, {"n", &knight_vectors}, {"k", &king_vectors}, {"p", &white_pawn_vectors} };
+tests black_tests = {
+	{"QB", &bishop_vectors}, {"QR", &rook_vectors}, {"N", &knight_vectors}, {"K", &king_vectors}, {"P", &black_pawn_vectors} };
+
+//packed midgame and endgame material plus position value of each piece on each square, from whites point of view,
+//black pieces are negated and read their position tables mirrored (63 - index),
+//kings are never taken so their material is left out, keeping the packed sums small
+constexpr auto MakePieceSquares()
+{
+	struct piece_value
+	{
+		char piece;
+		int midgame;
+		int endgame;
+		const std::array<int, 64>* midgame_positions;
+		const std::array<int, 64>* endgame_positions;
+	};
+	constexpr piece_value values[] = {
+		{'K', 0, 0, &evaluationMap::king, &evaluationMap::king_endgame},
+		{'Q', midgame_value_of::queen, endgame_value_of::queen, &evaluationMap::queen, &evaluationMap::queen_endgame},
+		{'R', midgame_value_of::rook, endgame_value_of::rook, &evaluationMap::rook, &evaluationMap::rook_endgame},
+		{'B', midgame_value_of::bishop, endgame_value_of::bishop, &evaluationMap::bishop, &evaluationMap::bishop_endgame},
+		{'N', midgame_value_of::knight, endgame_value_of::knight, &evaluationMap::knight, &evaluationMap::knight_endgame},
+		{'P', midgame_value_of::pawn, endgame_value_of::pawn, &evaluationMap::pawn, &evaluationMap::pawn_endgame} };
+	auto squares = std::array<std::array<int, 64>, piece_codes>{};
+	for (auto& value : values)
+	{
+		auto black_piece = char(value.piece - 'A' + 'a');
+		for (auto index = 0; index < 64; ++index)
+		{
+			squares[value.piece][index] = PackScore(value.midgame + (*value.midgame_positions)[index],
+				value.endgame + (*value.endgame_positions)[index]);
+			squares[black_piece][index] = -PackScore(value.midgame + (*value.midgame_positions)[63 - index],
+				value.endgame + (*value.endgame_positions)[63 - index]);
+		}
+	}
+	return squares;
+}
+constexpr auto piece_square = MakePieceSquares();
+
+//game phase weight of each piece
+constexpr auto MakePiecePhases()
+{
+	auto phases = std::array<int, piece_codes>{};
+	phases['Q'] = phases['q'] = phase_of::queen;
+	phases['R'] = phases['r'] = phase_of::rook;
+	phases['B'] = phases['b'] = phase_of::bishop;
+	phases['N'] = phases['n'] = phase_of::knight;
+	return phases;
+}
+constexpr auto piece_phase = MakePiecePhases();
+
+//zobrist hash keys, per board square contents and square, plus black to move
+struct zobrist_keys
+{
+	std::array<std::array<std::uint64_t, 64>, 128> pieces;
+	std::uint64_t black;
+};
+
+auto GenerateZobristKeys()
+{
+	//splitmix64 sequence, fixed seed so keys are the same every run
+	auto keys = zobrist_keys{};
+	auto seed = std::uint64_t{ 0x9E3779B97F4A7C15 };
+	auto next = [&]()
+	{
+		auto z = (seed += 0x9E3779B97F4A7C15);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+		return z ^ (z >> 31);
+	};
+	for (auto piece : std::string("prnbkqPRNBKQ"))
+	{
+		for (auto& key : keys.pieces[piece]) key = next();
+	}
+	keys.black = next();
+	return keys;
+}
+const auto zobrist = GenerateZobristKeys();
+
+//mate scores in the table are offset by more plies to mate than its 5 bit ply holds, so they stay beyond mate
+const int tt_mate_plies = 32;
+
+//transposition table entry, data packed into one word and the key stored xor data,
+//so an entry torn by two search threads writing at once fails the key test
+struct tt_entry
+{
+	std::atomic<std::uint64_t> key;
+	std::atomic<std::uint64_t> data;
+};
+
+//transposition table, replaced by search age then depth, kept alive between moves
+auto trans_table = std::unique_ptr<tt_entry[]>{};
+auto trans_table_size = std::size_t{ 0 };
+auto search_age = 0;
+
+//evaluation cache entry, the score stored like the transposition table with the key xor data
+struct eval_entry
+{
+	std::atomic<std::uint64_t> key;
+	std::atomic<std::uint64_t> data;
+};
+
+//pawn hash entry, packed pawn structure score and 4 bit shield counts per side and king file,
+//the key stored xor both so a torn entry fails the key test
+struct pawn_entry
+{
+	std::atomic<std::uint64_t> key;
+	std::atomic<std::uint64_t> score;
+	std::atomic<std::uint64_t> shields;
+};
+
+//fixed size evaluation and pawn structure caches, shared by all search threads
+auto eval_table = std::unique_ptr<eval_entry[]>(new eval_entry[control::eval_hash_size]());
+auto pawn_table = std::unique_ptr<pawn_entry[]>(new pawn_entry[control::pawn_hash_size]());
+
+#ifdef CHESSTOGO_SEARCH_STATS
+//search statistics of a thread, how the tree was cut, counted only in statistics builds
+struct search_stats
+{
+	std::array<std::uint64_t, control::max_ply + 2> nodes_at;
+	std::uint64_t leaves;
+	std::uint64_t eval_hits;
+	std::uint64_t tt_probes;
+	std::uint64_t tt_hits;
+	std::uint64_t tt_cutoffs;
+	std::uint64_t cutoffs;
+	std::uint64_t first_move_cutoffs;
+	std::uint64_t null_windows;
+	std::uint64_t re_searches;
+	std::uint64_t tablebase_exits;
+	std::uint64_t bitbase_draws;
+};
+#define SEARCH_STAT(counter) ++worker->stats.counter
+#else
+#define SEARCH_STAT(counter) ((void)0)
+#endif
+
+//per search thread move ordering tables, counters and the moves of each distance from the root, kept alive between moves
+struct alignas(64) search_thread
+{
+	std::array<std::array<tt_move, 2>, control::max_ply + 2> killers;
+	std::array<std::array<int, 64>, 128> history;
+	std::array<std::array<tt_move, control::max_ply + 2>, control::max_ply + 2> pv;
+	std::array<int, control::max_ply + 2> pv_length;
+	std::array<nnue_accumulator, control::max_ply + 2> accumulators;
+	std::array<move_list, control::max_ply + 2> moves;
+	int root_ply;
+	int seldepth;
+	std::atomic<std::uint64_t> nodes;
+	std::uint64_t tree_allocations;
+#ifdef CHESSTOGO_SEARCH_STATS
+	search_stats stats;
+#endif
+};
+auto search_threads = std::vector<std::unique_ptr<search_thread>>{};
+thread_local search_thread* worker = nullptr;
+
+//move ordering priorities, hash move first, then captures, killers and quiet moves by history
+namespace order_of {
+  const int hash_move = 1 << 30;
+  const int capture   = 1 << 29;
+  const int killer    = 1 << 28;
+}
+
+//root board of a search, with whether its score is exact and its principal variation
+struct root_board
+{
+	score_board sbrd;
+	bool exact;
+	boards pv;
+};
+typedef std::vector<root_board> root_boards;
+
+//expected line of the previous search, used to seed the next one
+namespace expected {
+  auto brd = std::string{};
+  auto ply = 0;
+}
+
+//generate all first hit pieces from index position along given vectors
+std::string PieceScans(const board& brd, unsigned int index, const vectors& vectors)
+{
+	auto yield = std::string{}; yield.reserve(8);
+	auto cx = int(index % 8);
+	auto cy = int(index / 8);
+	for (auto& vector : vectors)
+	{
+		auto dx = vector.dx;
+		auto dy = vector.dy;
+		auto length = vector.length;
+		auto x = cx;
+		auto y = cy;
+		for (; length > 0; --length)
+		{
+			x += dx;
+			y += dy;
+			if ((0 <= x) && (x < 8) && (0 <= y) && (y < 8))
+			{
+				//still on the board
+				auto piece = brd[y * 8 + x];
+				if (piece != ' ')
+				{
+					//not empty square so yield piece
+					yield.push_back(piece);
+					break;
+				}
+			}
+		}
+	}
+	return yield;
+}
+
+//test if king of given color is in check
+bool IsInCheck(const board& brd, int color, std::size_t& king_index)
+{
+	auto king_piece = 'K';
+	auto check_tests = &white_tests;
+	if (color == black)
+	{
+		//testing black king in check rather than white
+		king_piece = 'k';
+		check_tests = &black_tests;
+	}
+	//find king index on board
+	if (brd[king_index] != king_piece)
+	{
+		king_index = brd.find(king_piece);
+	}
+	for (auto& test : *check_tests)
+	{
+		if (test.pieces.find_first_of(PieceScans(brd, static_cast<unsigned int>(king_index), *test.check_vectors))
+			!= std::string::npos) return true;
+	}
+	//not in check
+	return false;
+}
+
+//packed material and position score of a board, from whites point of view
+int GetMaterial(const board& brd)
+{
+	//add score for piece type and position on the board, near center, clear lines etc
+	auto material = 0;
+	for (auto index = 0; index < 64; ++index)
+	{
+		material += piece_square[brd[index]][index];
+	}
+	return material;
+}
+
+//game phase of a board, midgame with all pieces on down to 0 with only kings and pawns left
+int GetPhase(const board& brd)
+{
+	auto phase = 0;
+	for (auto piece : brd) phase += piece_phase[piece];
+	return phase;
+}
+
+//zobrist hash key of the pawns alone, piece keys of anything but pawns are left out
+auto PawnKey(char piece, int index)
+{
+	return (piece == 'P' || piece == 'p') ? zobrist.pieces[piece][index] : std::uint64_t{ 0 };
+}
+
+std::uint64_t GetPawnKey(const board& brd)
+{
+	auto key = std::uint64_t{ 0 };
+	for (auto index = 0; index < 64; ++index)
+	{
+		key ^= PawnKey(brd[index], index);
+	}
+	return key;
+}
+
+//pawn structure of a board, from whites point of view, the shields are counted for every king file
+//and only applied for the squares the kings are on
+struct pawn_structure
+{
+	int score;
+	std::uint64_t shields;
+};
+
+auto EvaluatePawns(const board& brd)
+{
+	//pawns per file, and the row of the pawn furthest back of each side, row 0 being rank 8
+	auto white_pawns = std::array<int, 8>{};
+	auto black_pawns = std::array<int, 8>{};
+	auto white_last_row = std::array<int, 8>{ { -1, -1, -1, -1, -1, -1, -1, -1 } };
+	auto black_last_row = std::array<int, 8>{ { 8, 8, 8, 8, 8, 8, 8, 8 } };
+	for (auto index = 0; index < 64; ++index)
+	{
+		auto x = index % 8;
+		auto y = index / 8;
+		if (brd[index] == 'P')
+		{
+			++white_pawns[x];
+			white_last_row[x] = std::max(white_last_row[x], y);
+		}
+		else if (brd[index] == 'p')
+		{
+			++black_pawns[x];
+			black_last_row[x] = std::min(black_last_row[x], y);
+		}
+	}
+	auto structure = pawn_structure{ 0, 0 };
+	for (auto index = 0; index < 64; ++index)
+	{
+		auto piece = brd[index];
+		if (piece != 'P' && piece != 'p') continue;
+		auto x = index % 8;
+		auto y = index / 8;
+		auto& own = (piece == 'P') ? white_pawns : black_pawns;
+		auto score = 0;
+		if (own[x] > 1) score += pawn_value_of::doubled;
+		if ((x == 0 || own[x - 1] == 0) && (x == 7 || own[x + 1] == 0)) score += pawn_value_of::isolated;
+		//passed if no enemy pawn is ahead on this or the next files
+		auto passed = true;
+		for (auto file = std::max(x - 1, 0); file <= std::min(x + 1, 7); ++file)
+		{
+			if (piece == 'P' && black_last_row[file] < y) passed = false;
+			if (piece == 'p' && white_last_row[file] > y) passed = false;
+		}
+		if (passed) score += pawn_value_of::passed[(piece == 'P') ? 7 - y : y];
+		structure.score += (piece == 'P') ? score : -score;
+	}
+	//shield of a king on each file, 2 for a pawn right in front of the back rank and 1 for one a row further on
+	for (auto side = 0; side < 2; ++side)
+	{
+		auto pawn = (side == 0) ? 'P' : 'p';
+		auto near_row = (side == 0) ? 6 : 1;
+		auto far_row = (side == 0) ? 5 : 2;
+		for (auto king_file = 0; king_file < 8; ++king_file)
+		{
+			auto count = 0;
+			for (auto file = std::max(king_file - 1, 0); file <= std::min(king_file + 1, 7); ++file)
+			{
+				if (brd[near_row * 8 + file] == pawn) count += 2;
+				else if (brd[far_row * 8 + file] == pawn) count += 1;
+			}
+			structure.shields |= std::uint64_t(count) << ((side * 8 + king_file) * 4);
+		}
+	}
+	return structure;
+}
+
+//pawn structure score of a board with its pawn key, from whites point of view, from the pawn hash when there
+auto PawnStructure(const board& brd, std::uint64_t pawn_key)
+{
+	auto& entry = pawn_table[pawn_key & (control::pawn_hash_size - 1)];
+	auto score = entry.score.load(std::memory_order_relaxed);
+	auto shields = entry.shields.load(std::memory_order_relaxed);
+	auto structure = pawn_structure{ static_cast<int>(std::uint32_t(score)), shields };
+	if ((entry.key.load(std::memory_order_relaxed) ^ score ^ shields) != pawn_key)
+	{
+		structure = EvaluatePawns(brd);
+		score = std::uint32_t(structure.score);
+		entry.key.store(pawn_key ^ score ^ structure.shields, std::memory_order_relaxed);
+		entry.score.store(score, std::memory_order_relaxed);
+		entry.shields.store(structure.shields, std::memory_order_relaxed);
+	}
+	//shields only count for a king still by its back rank
+	auto white_king = int(brd.find('K'));
+	auto black_king = int(brd.find('k'));
+	if (white_king / 8 >= 6) structure.score += pawn_value_of::shield * int((structure.shields >> ((white_king % 8) * 4)) & 15);
+	if (black_king / 8 <= 1) structure.score -= pawn_value_of::shield * int((structure.shields >> ((8 + black_king % 8) * 4)) & 15);
+	return structure.score;
+}
+
+//score of a king and pawn against king board for the color to move from its bitbase result, a win is decisive
+//next to any evaluation but below a promoted queen, and higher the further the pawn is, so the search still pushes it
+auto KPKScore(const board& brd, int result)
+{
+	if (result == wdl::draw) return 0;
+	auto pawn = int(brd.find_first_of("Pp"));
+	auto advance = (brd[pawn] == 'P') ? 6 - pawn / 8 : pawn / 8 - 1;
+	auto score = value_of::queen / 2 + advance * value_of::pawn / 4;
+	return (result == wdl::win) ? score : -score;
+}
+
+//score of a king and pawn against king board of a phase from its bitbase, false for any other board,
+//every evaluation takes it first so they all agree
+auto BitbaseScore(const board& brd, int color, int phase, int& score)
+{
+	auto result = wdl::draw;
+	if (phase != 0 || !ProbeKPK(brd, color, result)) return false;
+	score = KPKScore(brd, result);
+	return true;
+}
+
+//evaluate (score) a board for the color given
+int GetEvaluation(const board& brd, int color)
+{
+	auto score = 0;
+	if (BitbaseScore(brd, color, GetPhase(brd), score)) return score;
+	if (NetworkEvaluates(brd))
+	{
+		auto accumulator = nnue_accumulator{};
+		RefreshAccumulator(brd, accumulator);
+		return NetworkEvaluation(accumulator, color);
+	}
+	return TaperScore(GetMaterial(brd) + PawnStructure(brd, GetPawnKey(brd)), GetPhase(brd)) * color;
+}
+
+//one byte piece code of each square content in a board batch, index into batch_pieces
+const char batch_pieces[] = " PNBRQKpnbrqk";
+
+constexpr auto MakeBatchCodes()
+{
+	auto codes = std::array<std::uint8_t, piece_codes>{};
+	for (auto code = 1; code < 13; ++code) codes[batch_pieces[code]] = static_cast<std::uint8_t>(code);
+	return codes;
+}
+constexpr auto batch_code = MakeBatchCodes();
+
+//piece_square and piece_phase by piece code, 16 codes so a phase lookup is one byte shuffle
+constexpr auto MakeBatchSquares()
+{
+	auto squares = std::array<std::array<std::int32_t, 16>, 64>{};
+	for (auto index = 0; index < 64; ++index)
+	{
+		for (auto code = 1; code < 13; ++code) squares[index][code] = piece_square[batch_pieces[code]][index];
+	}
+	return squares;
+}
+alignas(64) constexpr auto batch_square = MakeBatchSquares();
+
+constexpr auto MakeBatchPhases()
+{
+	auto phases = std::array<std::uint8_t, 16>{};
+	for (auto code = 1; code < 13; ++code) phases[code] = static_cast<std::uint8_t>(piece_phase[batch_pieces[code]]);
+	return phases;
+}
+alignas(16) constexpr auto batch_phase = MakeBatchPhases();
+
+//add a board to the end of a batch
+void AddToBatch(board_batch& batch, const board& brd)
+{
+	for (auto index = 0; index < 64; ++index) batch.squares[index].push_back(batch_code[brd[index]]);
+	++batch.size;
+}
+
+//board of a batch
+auto BatchBoard(const board_batch& batch, std::size_t position)
+{
+	auto brd = board(64, ' ');
+	for (auto index = 0; index < 64; ++index) brd[index] = batch_pieces[batch.squares[index][position]];
+	return brd;
+}
+
+//packed material and phase of the boards first to last of a batch, one board at a time
+void BatchMaterial(const board_batch& batch, std::size_t first, std::size_t last, int* material, int* phase)
+{
+	for (auto position = first; position < last; ++position)
+	{
+		auto board_material = 0;
+		auto board_phase = 0;
+		for (auto index = 0; index < 64; ++index)
+		{
+			auto code = batch.squares[index][position];
+			board_material += batch_square[index][code];
+			board_phase += batch_phase[code];
+		}
+		material[position] = board_material;
+		phase[position] = board_phase;
+	}
+}
+
+#ifdef BATCH_X86
+//eight boards at a time, gathering the piece square scores and shuffling the phase bytes,
+//a board has at most 30 pieces besides the kings so the byte phase sums can not overflow
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+void BatchMaterialAVX2(const board_batch& batch, std::size_t first, std::size_t last, int* material, int* phase)
+{
+	const auto phase_table = _mm_load_si128(reinterpret_cast<const __m128i*>(batch_phase.data()));
+	auto position = first;
+	for (; position + 8 <= last; position += 8)
+	{
+		auto sums = _mm256_setzero_si256();
+		auto phases = _mm_setzero_si128();
+		for (auto index = 0; index < 64; ++index)
+		{
+			auto codes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(batch.squares[index].data() + position));
+			phases = _mm_add_epi8(phases, _mm_shuffle_epi8(phase_table, codes));
+			sums = _mm256_add_epi32(sums, _mm256_i32gather_epi32(batch_square[index].data(), _mm256_cvtepu8_epi32(codes), 4));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(material + position), sums);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(phase + position), _mm256_cvtepu8_epi32(phases));
+	}
+	BatchMaterial(batch, position, last, material, phase);
+}
+
+//test if the cpu and os support avx2
+auto HasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	//os saves the ymm registers
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+//batch material function for this cpu, picked once at startup
+auto SelectBatchMaterial()
+{
+#ifdef BATCH_X86
+	if (HasAVX2()) return &BatchMaterialAVX2;
+#endif
+	return &BatchMaterial;
+}
+const auto batch_material = SelectBatchMaterial();
+
+//evaluate (score) all boards of a batch for the color given, the same scores as GetEvaluation
+void GetEvaluations(const board_batch& batch, int color, std::vector<int>& scores)
+{
+	scores.resize(batch.size);
+	if (NetworkLoaded())
+	{
+		//the network is evaluated board by board
+		for (auto position = std::size_t{ 0 }; position < batch.size; ++position)
+		{
+			scores[position] = GetEvaluation(BatchBoard(batch, position), color);
+		}
+		return;
+	}
+	auto phases = std::vector<int>(batch.size);
+	batch_material(batch, 0, batch.size, scores.data(), phases.data());
+	for (auto position = std::size_t{ 0 }; position < batch.size; ++position)
+	{
+		auto brd = BatchBoard(batch, position);
+		if (BitbaseScore(brd, color, phases[position], scores[position])) continue;
+		scores[position] = TaperScore(scores[position] + PawnStructure(brd, GetPawnKey(brd)), phases[position]) * color;
+	}
+}
+
+//zobrist hash key of a board for the color to move
+std::uint64_t GetKey(const board& brd, int color)
+{
+	auto key = (color == black) ? zobrist.black : std::uint64_t{ 0 };
+	for (auto index = 0; index < 64; ++index)
+	{
+		key ^= zobrist.pieces[brd[index]][index];
+	}
+	return key;
+}
+
+//add a generated board to the end of a list, into the storage of a board generated there before when there is one
+auto AddBoard(move_list& list, int score, const board& brd, int from, int to, char captured, int material, int phase,
+	std::uint64_t key, std::uint64_t pawn_key)
+{
+	if (list.size == list.boards.size()) list.boards.emplace_back();
+	auto& sbrd = list.boards[list.size++];
+	sbrd.score = score;
+	sbrd.bias = 0;
+	sbrd.brd.assign(brd);
+	sbrd.from = from;
+	sbrd.to = to;
+	sbrd.captured = captured;
+	sbrd.order = 0;
+	sbrd.material = material;
+	sbrd.phase = phase;
+	sbrd.key = key;
+	sbrd.pawn_key = pawn_key;
+}
+
+//generate all boards for a piece index and moves possibility, filtering out boards where king is in check,
+//the board is changed in place and restored, child material, phase and keys are the parents plus the squares that changed
+void PieceMoves(move_list& yield, board& brd, unsigned int index, int color, const moves& moves, std::size_t& king_index,
+	int material, int phase, std::uint64_t key, std::uint64_t pawn_key)
+{
+	auto piece = brd[index];
+	auto from_material = material - piece_square[piece][index];
+	auto from_key = key ^ zobrist.black ^ zobrist.pieces[piece][index];
+	auto from_pawn_key = pawn_key ^ PawnKey(piece, index);
+	auto promote = std::string("qrbn");
+	if (color == white) promote = "QRBN";
+	auto cx = int(index % 8);
+	auto cy = int(index / 8);
+	for (auto& move : moves)
+	{
+		auto dx = move.dx;
+		auto dy = move.dy;
+		auto length = move.length;
+		auto flag = move.flag;
+		auto x = cx;
+		auto y = cy;
+		//special length for pawns so we can adjust for starting 2 hop
+		if (length == 0)
+		{
+			length = 1;
+			if (piece == 'p')
+			{
+				if (y == 1) length = 2;
+			}
+			else
+			{
+				if (y == 6) length = 2;
+			}
+		}
+		for (; length > 0; --length)
+		{
+			x += dx;
+			y += dy;
+			if ((x < 0) || (x >= 8) || (y < 0) || (y >= 8))
+			{
+				//gone off the board
+				break;
+			}
+			auto newindex = y * 8 + x;
+			auto newpiece = brd[newindex];
+			auto newtype = piece_type[newpiece];
+			if (newtype == color)
+			{
+				//hit one of our own piece type (black hit black etc)
+				break;
+			}
+			if ((flag == no_capture) && (newtype != empty))
+			{
+				//not suposed to capture and not empty square
+				break;
+			}
+			if ((flag == must_capture) && (newtype == empty))
+			{
+				//must capture and got empty square
+				break;
+			}
+			brd[index] = ' ';
+			auto to_material = from_material - piece_square[newpiece][newindex];
+			auto to_key = from_key ^ zobrist.pieces[newpiece][newindex];
+			auto to_phase = phase - piece_phase[newpiece];
+			auto to_pawn_key = from_pawn_key ^ PawnKey(newpiece, newindex);
+			if ((y == 0 || y == 7) && (piece == 'P' || piece == 'p'))
+			{
+				//try all the pawn promotion possibilities
+				for (auto& promote_piece : promote)
+				{
+					brd[newindex] = promote_piece;
+					if (IsInCheck(brd, color, king_index)) continue;
+					auto new_material = to_material + piece_square[promote_piece][newindex];
+					auto new_phase = to_phase + piece_phase[promote_piece];
+					AddBoard(yield, TaperScore(new_material, new_phase) * color, brd, int(index), newindex, newpiece,
+						new_material, new_phase, to_key ^ zobrist.pieces[promote_piece][newindex], to_pawn_key);
+				}
+			}
+			else
+			{
+				//generate this as a possible move
+				brd[newindex] = piece;
+				if (!IsInCheck(brd, color, king_index))
+				{
+					auto new_material = to_material + piece_square[piece][newindex];
+					AddBoard(yield, TaperScore(new_material, to_phase) * color, brd, int(index), newindex, newpiece,
+						new_material, to_phase, to_key ^ zobrist.pieces[piece][newindex], to_pawn_key ^ PawnKey(piece, newindex));
+				}
+			}
+			brd[index] = piece;
+			brd[newindex] = newpiece;
+			if ((flag == may_capture) && (newtype != empty))
+			{
+				//may capture and we did so !
+				break;
+			}
+		}
+	}
+}
+
+//generate all moves (boards) for the given colors turn from a generated board into a list, using its material, phase and keys
+void GenerateMoves(move_list& yield, const score_board& sbrd, int color)
+{
+	//enumarate the board square by square
+	yield.size = 0;
+	std::size_t king_index = 0;
+	auto is_black = (color == black);
+	auto& brd = yield.scratch;
+	brd.assign(sbrd.brd);
+	auto len = int(brd.length());
+	for (auto index = 0; index < len; ++index)
+	{
+		auto piece = brd[index];
+		if (piece == ' ') continue;
+		if (piece > 'Z' != is_black) continue;
+		//one of our pieces ! so gather all boards from possible moves of this piece
+		PieceMoves(yield, brd, index, color, *moves_map[piece], king_index, sbrd.material, sbrd.phase, sbrd.key, sbrd.pawn_key);
+	}
+}
+
+//generate all moves (boards) for the given colors turn from a generated board, using its material, phase and keys
+score_boards GetAllMoves(const score_board& sbrd, int color)
+{
+	auto yield = move_list{};
+	yield.boards.reserve(control::max_chess_moves);
+	GenerateMoves(yield, sbrd, color);
+	yield.boards.resize(yield.size);
+	return std::move(yield.boards);
+}
+
+//generate all moves (boards) for the given colors turn
+score_boards GetAllMoves(const board& brd, int color)
+{
+	auto sbrd = score_board{ 0, 0, brd, -1, -1, ' ', 0, GetMaterial(brd), GetPhase(brd), GetKey(brd, color), GetPawnKey(brd) };
+	return GetAllMoves(sbrd, color);
+}
+
+//leaf boards of the moves to a depth from a generated board, the last moves counted without playing them
+std::uint64_t PerftNodes(const score_board& sbrd, int color, int depth)
+{
+	auto next_boards = GetAllMoves(sbrd, color);
+	if (depth <= 1) return next_boards.size();
+	auto nodes = std::uint64_t{ 0 };
+	for (auto& next : next_boards) nodes += PerftNodes(next, -color, depth - 1);
+	return nodes;
+}
+
+//count the leaf boards of all moves to a depth
+std::uint64_t Perft(const board& brd, int color, int depth)
+{
+	if (depth <= 0) return 1;
+	auto sbrd = score_board{ 0, 0, brd, -1, -1, ' ', 0, GetMaterial(brd), GetPhase(brd), GetKey(brd, color), GetPawnKey(brd) };
+	return PerftNodes(sbrd, color, depth);
+}
+
+//start of move time, and the limits shared by all search threads
+auto start_time = std::chrono::high_resolution_clock::now();
+auto time_limit = std::atomic<float>{ control::max_time_per_move };
+auto search_done = std::atomic<bool>{ false };
+const std::atomic<bool>* stop_request = nullptr;
+auto node_limit = std::uint64_t{ 0 };
+
+//evaluate leaves with the neural network, fixed for the whole search
+auto use_network = false;
+auto probe_pieces = 0;
+
+//seconds since the start of move time
+auto Elapsed()
+{
+	std::chrono::duration<float> elapsed = std::chrono::high_resolution_clock::now() - start_time;
+	return elapsed.count();
+}
+
+//test if the search must stop, the timer expired, the front-end asked, the main thread finished or the thread searched its nodes
+auto TimeUp()
+{
+	if (search_done.load(std::memory_order_relaxed)) return true;
+	if (stop_request && stop_request->load(std::memory_order_relaxed)) return true;
+	if (node_limit != 0 && worker->nodes.load(std::memory_order_relaxed) >= node_limit) return true;
+	return Elapsed() >= time_limit.load(std::memory_order_relaxed);
+}
+
+//test if a generated board was produced by the given move
+auto IsMove(const score_board& sbrd, const tt_move& move)
+{
+	return sbrd.from == move.from && sbrd.to == move.to && sbrd.brd[sbrd.to] == move.piece;
+}
+
+//move that produced a generated board
+auto ToMove(const score_board& sbrd)
+{
+	return tt_move{ static_cast<std::int8_t>(sbrd.from), static_cast<std::int8_t>(sbrd.to), sbrd.brd[sbrd.to] };
+}
+
+//transposition table slot for a key
+auto& TTEntry(std::uint64_t key)
+{
+	return trans_table[key & (trans_table_size - 1)];
+}
+
+//data word layout, score 32 bits, ply 5, flag 2, age 6, from 6, to 6 and piece 7
+auto TTPack(int score, int ply, int flag, const tt_move& move)
+{
+	return std::uint64_t(std::uint32_t(score))
+		| std::uint64_t(ply & 31) << 32
+		| std::uint64_t(flag & 3) << 37
+		| std::uint64_t(search_age & 63) << 39
+		| std::uint64_t(move.from & 63) << 45
+		| std::uint64_t(move.to & 63) << 51
+		| std::uint64_t(move.piece & 127) << 57;
+}
+
+auto TTUnpack(std::uint64_t word)
+{
+	auto move = tt_move{ static_cast<std::int8_t>((word >> 45) & 63), static_cast<std::int8_t>((word >> 51) & 63), static_cast<char>((word >> 57) & 127) };
+	if (move.piece == ' ') move = no_move;
+	return tt_data{ static_cast<int>(std::uint32_t(word)), int((word >> 32) & 31), int((word >> 37) & 3), int((word >> 39) & 63), move };
+}
+
+//look up a key, false if not stored
+bool TTProbe(std::uint64_t key, tt_data& data)
+{
+	auto& entry = TTEntry(key);
+	auto word = entry.data.load(std::memory_order_relaxed);
+	if ((entry.key.load(std::memory_order_relaxed) ^ word) != key) return false;
+	data = TTUnpack(word);
+	return true;
+}
+
+//store a search result, entries from older searches or shallower plies are replaced
+void TTStore(std::uint64_t key, int score, int ply, int flag, const tt_move& move)
+{
+	auto& entry = TTEntry(key);
+	auto word = entry.data.load(std::memory_order_relaxed);
+	auto old = TTUnpack(word);
+	if ((entry.key.load(std::memory_order_relaxed) ^ word) == key || old.age != (search_age & 63) || ply >= old.ply)
+	{
+		word = TTPack(score, ply, flag, move);
+		entry.key.store(key ^ word, std::memory_order_relaxed);
+		entry.data.store(word, std::memory_order_relaxed);
+	}
+}
+
+//mate scores carry the remaining ply of the mated node, so depend on where a node is in the tree,
+//the table keeps them as plies to mate from the node at its remaining ply instead
+auto ToTTScore(int score, int ply)
+{
+	if (score > value_of::mate) return score - ply + tt_mate_plies;
+	if (score < -value_of::mate) return score + ply - tt_mate_plies;
+	return score;
+}
+
+//a score of the table for a node at a remaining ply, false for a mate beyond its horizon which the node can not score
+auto FromTTScore(int& score, int ply)
+{
+	if (score > value_of::mate) score += ply - tt_mate_plies;
+	else if (score < -value_of::mate) score -= ply - tt_mate_plies;
+	else return true;
+	return score > value_of::mate || score < -value_of::mate;
+}
+
+//static evaluation of a generated board for the color to move, from the evaluation cache when there,
+//the network reads the boards accumulator at its distance from the root
+auto Evaluate(const score_board& sbrd, int color, int distance)
+{
+	auto& entry = eval_table[sbrd.key & (control::eval_hash_size - 1)];
+	auto word = entry.data.load(std::memory_order_relaxed);
+	if ((entry.key.load(std::memory_order_relaxed) ^ word) == sbrd.key)
+	{
+		SEARCH_STAT(eval_hits);
+		return static_cast<int>(std::uint32_t(word));
+	}
+	auto score = 0;
+	if (!BitbaseScore(sbrd.brd, color, sbrd.phase, score)) score = use_network ? NetworkEvaluation(worker->accumulators[distance], color)
+		: TaperScore(sbrd.material + PawnStructure(sbrd.brd, sbrd.pawn_key), sbrd.phase) * color;
+	word = std::uint32_t(score);
+	entry.key.store(sbrd.key ^ word, std::memory_order_relaxed);
+	entry.data.store(word, std::memory_order_relaxed);
+	return score;
+}
+
+//order boards for searching, hash move first, then captures, killers and quiet moves by history
+auto OrderMoves(move_list& next_boards, const tt_move& hash_move, int distance)
+{
+	auto& killer = worker->killers[distance];
+	for (auto& sbrd : next_boards)
+	{
+		if (IsMove(sbrd, hash_move)) sbrd.order = order_of::hash_move;
+		else if (sbrd.captured != ' ') sbrd.order = order_of::capture + sbrd.score;
+		else if (IsMove(sbrd, killer[0])) sbrd.order = order_of::killer;
+		else if (IsMove(sbrd, killer[1])) sbrd.order = order_of::killer - 1;
+		else sbrd.order = sbrd.score + worker->history[sbrd.brd[sbrd.to]][sbrd.to];
+	}
+	std::sort(next_boards.begin(), next_boards.end(), [&](const auto& brd1, const auto& brd2)
+		{
+			return brd1.order > brd2.order;
+		});
+}
+
+//remember a quiet move that caused a beta cutoff in the killer and history tables
+auto UpdateQuietCutoff(const score_board& sbrd, int distance, int ply)
+{
+	auto& killer = worker->killers[distance];
+	if (!IsMove(sbrd, killer[0]))
+	{
+		killer[1] = killer[0];
+		killer[0] = ToMove(sbrd);
+	}
+	auto& entry = worker->history[sbrd.brd[sbrd.to]][sbrd.to];
+	entry += ply * ply;
+	if (entry > control::max_history)
+	{
+		//keep history scores bounded
+		for (auto& piece_history : worker->history)
+		{
+			for (auto& value : piece_history) value /= 2;
+		}
+	}
+}
+
+//triangular pv, the line at a distance is its best move followed by the line of the child
+auto UpdatePV(const score_board& sbrd, int distance)
+{
+	auto& pv = worker->pv;
+	auto& pv_length = worker->pv_length;
+	pv[distance][distance] = ToMove(sbrd);
+	for (auto index = distance + 1; index < pv_length[distance + 1]; ++index)
+	{
+		pv[distance][index] = pv[distance + 1][index];
+	}
+	pv_length[distance] = pv_length[distance + 1];
+}
+
+//memoized scores
+int ScoreImpl(const score_board& sbrd, int color, int alpha, int beta, int ply, tt_move& best_move);
+
+auto Score(const score_board& sbrd, int color, int alpha, int beta, int ply)
+{
+	auto best_move = no_move;
+	auto distance = worker->root_ply - ply + 1;
+	worker->pv_length[distance] = distance;
+	worker->seldepth = std::max(worker->seldepth, distance);
+	if (ply < 2) return ScoreImpl(sbrd, color, alpha, beta, ply, best_move);
+	auto key = sbrd.key;
+	auto entry = tt_data{};
+	SEARCH_STAT(tt_probes);
+	if (TTProbe(key, entry))
+	{
+		//use the stored bound if searched deep enough, else just its move for ordering
+		SEARCH_STAT(tt_hits);
+		if (entry.ply >= ply && FromTTScore(entry.score, ply))
+		{
+			auto cutoff = entry.flag == bound::exact || (entry.flag == bound::lower && entry.score >= beta)
+				|| (entry.flag == bound::upper && entry.score <= alpha);
+			if (cutoff) SEARCH_STAT(tt_cutoffs);
+			if (entry.flag == bound::exact) return std::min(std::max(entry.score, alpha), beta);
+			if (entry.flag == bound::lower && entry.score >= beta) return beta;
+			if (entry.flag == bound::upper && entry.score <= alpha) return alpha;
+		}
+		best_move = entry.move;
+	}
+	auto score = ScoreImpl(sbrd, color, alpha, beta, ply, best_move);
+	if (score == value_of::timeout || score == -value_of::timeout) return score;
+	auto flag = bound::exact;
+	if (score <= alpha) flag = bound::upper;
+	else if (score >= beta) flag = bound::lower;
+	TTStore(key, ToTTScore(score, ply), ply, flag, best_move);
+	return score;
+}
+
+//pieces left on a board
+auto PieceCount(const board& brd)
+{
+	return 64 - static_cast<int>(std::count(begin(brd), end(brd), ' '));
+}
+
+//score of a tablebase result, wins beyond any evaluation and sooner ones first,
+//cursed wins and blessed losses lose to the fifty move rule so are just better than a draw
+auto TablebaseScore(int result, int distance)
+{
+	if (result == wdl::win) return value_of::tablebase_win - distance;
+	if (result == wdl::loss) return -value_of::tablebase_win + distance;
+	return result;
+}
+
+//pvs alpha/beta pruning minmax search for given ply, best_move is the hash move in and best move out
+int ScoreImpl(const score_board& sbrd, int color, int alpha, int beta, int ply, tt_move& best_move)
+{
+	worker->nodes.store(worker->nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	auto distance = worker->root_ply - ply + 1;
+	SEARCH_STAT(nodes_at[distance]);
+	if (probe_pieces != 0 && sbrd.captured != ' ' && PieceCount(sbrd.brd) <= probe_pieces)
+	{
+		//captured down into the tablebases, the result is exact
+		auto result = wdl::draw;
+		if (ProbeWDL(sbrd.brd, color, result))
+		{
+			SEARCH_STAT(tablebase_exits);
+			return std::min(std::max(TablebaseScore(result, distance), alpha), beta);
+		}
+	}
+	auto kpk_result = wdl::win;
+	if (sbrd.phase == 0 && ProbeKPK(sbrd.brd, color, kpk_result) && kpk_result == wdl::draw)
+	{
+		//a bitbase draw is exact, wins are still searched for the way to promote
+		SEARCH_STAT(bitbase_draws);
+		return std::min(std::max(0, alpha), beta);
+	}
+	if (ply == 0)
+	{
+		SEARCH_STAT(leaves);
+		return Evaluate(sbrd, color, distance);
+	}
+	auto& next_boards = worker->moves[distance];
+	GenerateMoves(next_boards, sbrd, color);
+	auto mate = true;
+	if (next_boards.size != 0)
+	{
+		if (ply > 1) OrderMoves(next_boards, best_move, distance);
+		for (auto& score_board : next_boards)
+		{
+			int value;
+			if (use_network)
+			{
+				//the childs accumulator is the parents plus the squares that changed
+				UpdateAccumulator(worker->accumulators[distance], sbrd.brd, score_board.brd, score_board.from, score_board.to,
+					worker->accumulators[distance + 1]);
+			}
+			if (!mate)
+			{
+				//not first child so null search window
+				SEARCH_STAT(null_windows);
+				value = -Score(score_board, -color, -alpha - 1, -alpha, ply - 1);
+				if (alpha < value && value < beta)
+				{
+					//failed high, so full re-search
+					SEARCH_STAT(re_searches);
+					value = -Score(score_board, -color, -beta, -alpha, ply - 1);
+				}
+			}
+			else
+			{
+				value = -Score(score_board, -color, -beta, -alpha, ply - 1);
+			}
+			mate = false;
+			if (value == value_of::timeout || value == -value_of::timeout)
+			{
+				//move time out
+				return value;
+			}
+			if (value >= value_of::mate)
+			{
+				//early return if mate
+				best_move = ToMove(score_board);
+				UpdatePV(score_board, distance);
+				return value;
+			}
+			if (value >= beta)
+			{
+				//fail hard beta cutoff
+				SEARCH_STAT(cutoffs);
+				if (&score_board == next_boards.begin()) SEARCH_STAT(first_move_cutoffs);
+				best_move = ToMove(score_board);
+				if (score_board.captured == ' ') UpdateQuietCutoff(score_board, distance, ply);
+				return beta;
+			}
+			if (value > alpha)
+			{
+				alpha = value;
+				best_move = ToMove(score_board);
+				UpdatePV(score_board, distance);
+			}
+			if (TimeUp())
+			{
+				//time has expired for this move
+				return value_of::timeout;
+			}
+		}
+	}
+	if (!mate) return alpha;
+	std::size_t king_index = 0;
+	if (IsInCheck(sbrd.brd, color, king_index))
+	{
+		//check mate
+		return -value_of::mate - ply;
+	}
+	//stale mate
+	return value_of::mate;
+}
+
+//boards along the principal variation of a root board, from the triangular pv table
+auto RootLine(const score_board& sbrd, int color)
+{
+	auto line = boards{ sbrd.brd };
+	auto brd = sbrd.brd;
+	auto& pv = worker->pv[1];
+	for (auto index = 1; index < worker->pv_length[1]; ++index)
+	{
+		color = -color;
+		auto next_boards = GetAllMoves(brd, color);
+		auto found = std::find_if(begin(next_boards), end(next_boards), [&](const auto& next)
+			{
+				return IsMove(next, pv[index]);
+			});
+		if (found == end(next_boards)) break;
+		brd = found->brd;
+		line.push_back(brd);
+	}
+	return line;
+}
+
+//nodes searched by all threads since the start of the move
+auto SearchedNodes()
+{
+	auto nodes = std::uint64_t{ 0 };
+	for (auto& thread : search_threads) nodes += thread->nodes.load(std::memory_order_relaxed);
+	return nodes;
+}
+
+//permille of the hash table used by the current search, sampled from its first entries
+auto HashFull()
+{
+	auto sample = std::min(trans_table_size, std::size_t{ 1000 });
+	auto used = std::size_t{ 0 };
+	for (auto index = std::size_t{ 0 }; index < sample; ++index)
+	{
+		auto word = trans_table[index].data.load(std::memory_order_relaxed);
+		if (word != 0 && TTUnpack(word).age == (search_age & 63)) ++used;
+	}
+	return static_cast<int>(used * 1000 / sample);
+}
+
+//iterative deepening over the root boards, returns the last completed ply
+auto SearchRoot(root_boards& roots, int color, int start_ply, const search_limits& limits, std::uint64_t key, const info_callback& report)
+{
+	auto multi_pv = std::max(1, std::min(limits.multi_pv, static_cast<int>(roots.size())));
+	auto completed_ply = 0;
+	for (auto ply = start_ply; ply <= limits.ply; ++ply)
+	{
+		//iterative deepening of ply so we always have a best move to go with if the timer expires
+		auto iteration_trace = trace_scope("iteration", "depth", ply + 1);
+		worker->root_ply = ply;
+		auto beta = value_of::mate * 10;
+		auto best_scores = std::vector<int>{};
+		auto timed_out = false;
+		for (auto& root : roots)
+		{
+			//window opens at the multi_pv best score so far, so each of the best boards gets an exact score
+			auto root_trace = trace_scope("root move", "order", static_cast<int>(&root - roots.data()));
+			auto alpha = -value_of::mate * 10;
+			if (static_cast<int>(best_scores.size()) == multi_pv) alpha = best_scores.back();
+			auto score_board = &root.sbrd;
+			if (use_network) RefreshAccumulator(score_board->brd, worker->accumulators[1]);
+			auto allocated = ThreadAllocationCount().allocations;
+			score_board->score = -Score(*score_board, -color, -beta, -alpha, ply);
+			worker->tree_allocations += ThreadAllocationCount().allocations - allocated;
+			if (score_board->score == value_of::timeout || score_board->score == -value_of::timeout)
+			{
+				//move timer expired
+				timed_out = true;
+				break;
+			}
+			score_board->score += score_board->bias;
+			root.exact = score_board->score > alpha;
+			if (root.exact)
+			{
+				//got one of the best boards so far
+				root.pv = RootLine(*score_board, color);
+				best_scores.insert(std::upper_bound(begin(best_scores), end(best_scores), score_board->score, std::greater<int>()), score_board->score);
+				if (static_cast<int>(best_scores.size()) > multi_pv) best_scores.pop_back();
+			}
+		}
+		if (timed_out) break;
+
+		//promote exact boards to the front best first, the rest keep their order
+		auto split = std::stable_partition(begin(roots), end(roots), [](const auto& root)
+			{
+				return root.exact;
+			});
+		std::stable_sort(begin(roots), split, [](const auto& root1, const auto& root2)
+			{
+				return root1.sbrd.score > root2.sbrd.score;
+			});
+		completed_ply = ply;
+		auto& best = roots[0].sbrd;
+		TTStore(key, ToTTScore(best.score - best.bias, ply + 1), ply + 1, bound::exact, ToMove(best));
+		if (report)
+		{
+			for (auto index = 0; index < multi_pv; ++index)
+			{
+				report(search_info{ ply + 1, worker->seldepth, roots[index].sbrd.score, SearchedNodes(), Elapsed(), HashFull(),
+					roots[index].pv, index + 1 });
+			}
+		}
+		if (best.score >= value_of::mate || best.score <= -value_of::mate)
+		{
+			//don't look further ahead if we allready can force mate
+			break;
+		}
+	}
+	return completed_ply;
+}
+
+#ifdef CHESSTOGO_SEARCH_STATS
+//percent of a count in a total
+auto Percent(std::uint64_t count, std::uint64_t total)
+{
+	return std::to_string(total ? count * 100 / total : 0) + "%";
+}
+
+//print the search statistics of all threads added up, to stderr to keep out of the front-end output
+auto PrintSearchStats()
+{
+	auto total = search_stats{};
+	for (auto& thread : search_threads)
+	{
+		auto& stats = thread->stats;
+		for (auto index = std::size_t{ 0 }; index < total.nodes_at.size(); ++index) total.nodes_at[index] += stats.nodes_at[index];
+		total.leaves += stats.leaves;
+		total.eval_hits += stats.eval_hits;
+		total.tt_probes += stats.tt_probes;
+		total.tt_hits += stats.tt_hits;
+		total.tt_cutoffs += stats.tt_cutoffs;
+		total.cutoffs += stats.cutoffs;
+		total.first_move_cutoffs += stats.first_move_cutoffs;
+		total.null_windows += stats.null_windows;
+		total.re_searches += stats.re_searches;
+		total.tablebase_exits += stats.tablebase_exits;
+		total.bitbase_draws += stats.bitbase_draws;
+	}
+	auto nodes = std::string{};
+	for (auto index = std::size_t{ 1 }; index < total.nodes_at.size() && total.nodes_at[index] != 0; ++index)
+	{
+		nodes += " " + std::to_string(total.nodes_at[index]);
+	}
+	std::cerr << "search stats\n"
+		<< "  nodes by depth" << nodes << "\n"
+		<< "  leaves " << total.leaves << ", evaluation cache hits " << Percent(total.eval_hits, total.leaves) << "\n"
+		<< "  hash probes " << total.tt_probes << ", hits " << Percent(total.tt_hits, total.tt_probes)
+		<< ", cutoffs " << Percent(total.tt_cutoffs, total.tt_probes) << "\n"
+		<< "  beta cutoffs " << total.cutoffs << ", on the first move " << Percent(total.first_move_cutoffs, total.cutoffs) << "\n"
+		<< "  null window searches " << total.null_windows << ", re-searched " << Percent(total.re_searches, total.null_windows) << "\n"
+		<< "  tablebase exits " << total.tablebase_exits << ", bitbase draws " << total.bitbase_draws << std::endl;
+}
+#endif
+
+//allocations of the threads below the roots of the search, the search tree itself without the root moves and lines
+auto TreeAllocations()
+{
+	auto allocations = std::uint64_t{ 0 };
+	for (auto& thread : search_threads) allocations += thread->tree_allocations;
+	return allocations;
+}
+
+//print the allocations of a search since a count, per node searched, and those below the roots,
+//to stderr to keep out of the front-end output
+auto PrintSearchAllocations(const allocation_count& before)
+{
+	auto after = AllocationCount();
+	auto nodes = std::max<std::uint64_t>(SearchedNodes(), 1);
+	auto allocations = after.allocations - before.allocations;
+	auto bytes = after.bytes - before.bytes;
+	std::cerr << "search allocations " << allocations << " (" << double(allocations) / nodes << " per node), bytes " << bytes
+		<< " (" << double(bytes) / nodes << " per node), below the roots " << TreeAllocations() << std::endl;
+}
+
+//remember the position expected after our move and the predicted reply
+auto SetExpectedLine(const root_board& best, int ply)
+{
+	expected::brd.clear();
+	if (best.pv.size() < 2) return;
+	//first iteration for that position not already covered by the hash table
+	expected::brd = best.pv[1];
+	expected::ply = ply - 1;
+}
+
+//create the hash table and main thread on first use
+void InitSearch()
+{
+	if (!trans_table) SetHashSize(control::hash_size_mb);
+	if (search_threads.empty()) SetThreads(1);
+	worker = search_threads[0].get();
+}
+
+//report a position given its move without a search, mated, in book or with a single move, as one depth 1 line
+auto ReportUnsearched(const info_callback& report, int score, const boards& pv)
+{
+	if (report) report(search_info{ 1, pv.empty() ? 0 : 1, score, 0, 0, HashFull(), pv, 1 });
+}
+
+//best move for given board position for given color
+board GetBestMove(const board& brd, int color, const boards& history, const search_limits& limits, const info_callback& report)
+{
+	auto search_trace = trace_scope("search");
+	InitSearch();
+	auto allocated = AllocationCount();
+
+	//first ply of boards
+	auto next_boards = GetAllMoves(brd, color);
+	for (auto& sbrd : next_boards)
+	{
+		auto rep = std::count(begin(history), end(history), sbrd.brd);
+		sbrd.bias = static_cast<int>(-(rep * value_of::queen));
+	}
+	if (next_boards.size() == 0)
+	{
+		//mated or stalemated, no move to give
+		std::size_t king_index = 0;
+		ReportUnsearched(report, IsInCheck(brd, color, king_index) ? -value_of::mate - 1 : 0, boards{});
+		return std::string("");
+	}
+	auto book_move = board{};
+	if (limits.book && BookMove(brd, color, history, next_boards, book_move))
+	{
+		//in book, no search
+		auto found = std::find_if(begin(next_boards), end(next_boards), [&](const auto& sbrd)
+			{
+				return sbrd.brd == book_move;
+			});
+		ReportUnsearched(report, (found != end(next_boards)) ? found->score : 0, boards{ book_move });
+		return book_move;
+	}
+	probe_pieces = TablebasePieces();
+	auto tablebase_result = wdl::draw;
+	auto in_tablebases = probe_pieces != 0 && PieceCount(brd) <= probe_pieces;
+	if (in_tablebases)
+	{
+		//in the tablebases only the moves that keep the result are searched, the quickest to zeroing when winning
+		in_tablebases = FilterRootMoves(brd, color, next_boards) && ProbeWDL(brd, color, tablebase_result);
+	}
+	if (next_boards.size() == 1)
+	{
+		//the only move, or the only one keeping the tablebase result
+		auto score = in_tablebases ? TablebaseScore(tablebase_result, 0) : next_boards[0].score + next_boards[0].bias;
+		ReportUnsearched(report, score, boards{ next_boards[0].brd });
+		return next_boards[0].brd;
+	}
+	std::sort(begin(next_boards), end(next_boards), [&](const auto& brd1, const auto& brd2)
+		{
+			return brd1.score > brd2.score;
+		});
+	if (limits.book) ExplorerOrder(brd, color, history, next_boards);
+
+	//age the tables rather than clearing them, so work from the previous move carries over
+	++search_age;
+	auto start_ply = 1;
+	auto on_expected_line = (brd == expected::brd);
+	if (on_expected_line)
+	{
+		//opponent played the expected reply, resume deepening where the hash table leaves off
+		start_ply = std::max(1, std::min(expected::ply, limits.ply));
+	}
+	for (auto& thread : search_threads)
+	{
+		for (auto& piece_history : thread->history)
+		{
+			for (auto& value : piece_history) value /= 2;
+		}
+		if (on_expected_line)
+		{
+			//killers move two plies up the tree
+			std::copy(begin(thread->killers) + 2, end(thread->killers), begin(thread->killers));
+			std::fill(end(thread->killers) - 2, end(thread->killers), std::array<tt_move, 2>{ no_move, no_move });
+		}
+		thread->nodes = 0;
+		thread->seldepth = 0;
+		thread->tree_allocations = 0;
+#ifdef CHESSTOGO_SEARCH_STATS
+		thread->stats = {};
+#endif
+	}
+	auto key = GetKey(brd, color);
+	auto entry = tt_data{};
+	if (TTProbe(key, entry))
+	{
+		//hash move goes first
+		auto found = std::find_if(begin(next_boards), end(next_boards), [&](const auto& sbrd)
+			{
+				return IsMove(sbrd, entry.move);
+			});
+		if (found != end(next_boards)) std::rotate(begin(next_boards), found, found + 1);
+	}
+	auto roots = root_boards{};
+	roots.reserve(next_boards.size());
+	for (auto& sbrd : next_boards) roots.push_back(root_board{ sbrd, false, boards{} });
+
+	//start move timer
+	start_time = std::chrono::high_resolution_clock::now();
+	time_limit = limits.time;
+	stop_request = limits.stop;
+	node_limit = limits.nodes;
+	search_done = false;
+	use_network = NetworkEvaluates(brd);
+
+	//helper threads search the same root sharing the hash table, odd ones a ply deeper
+	auto helpers = std::vector<std::thread>{};
+	for (auto index = 1; index < static_cast<int>(search_threads.size()); ++index)
+	{
+		//each helper gets its copy of the roots here, the main thread reorders its own as soon as it searches
+		helpers.emplace_back([&, index, helper_roots = roots]() mutable
+			{
+				worker = search_threads[index].get();
+				NameTraceThread("search " + std::to_string(index));
+				SearchRoot(helper_roots, color, start_ply + index % 2, limits, key, nullptr);
+			});
+	}
+	auto completed_ply = SearchRoot(roots, color, start_ply, limits, key, report);
+	search_done = true;
+	for (auto& helper : helpers) helper.join();
+#ifdef CHESSTOGO_SEARCH_STATS
+	PrintSearchStats();
+#endif
+	if (TracksAllocations()) PrintSearchAllocations(allocated);
+
+	SetExpectedLine(roots[0], completed_ply);
+	return roots[0].sbrd.brd;
+}
+
+//bench positions, openings, middlegames, endgames and mates
+const char* const bench_fens[bench_positions] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+	"4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+	"rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+	"r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+	"r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+	"r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+	"r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+	"4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+	"2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+	"r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+	"3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+	"r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+	"4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+	"3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+	"6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+	"3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+	"2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+	"8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+	"7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+	"8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+	"8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+	"8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+	"8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+	"5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+	"6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+	"1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+	"6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+	"8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+	"5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+	"4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+	"r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+	"3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+	"4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+	"r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+	"rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+	"r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 10",
+	"2r3k1/pp3ppp/8/3Pp3/1P2P3/P7/5PPP/2R3K1 w - - 0 1",
+	"8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+	"8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+	"8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+	"8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+	"8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+	"8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+	"8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+	"6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+	"r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+	"8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+	"7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+};
+
+//search the built-in bench positions to a depth on one thread
+bench_result Bench(int depth, int hash_mb, const std::function<void(const std::string& fen, const search_info& info)>& report)
+{
+	SetThreads(1);
+	SetHashSize(hash_mb);
+	auto limits = search_limits{};
+	limits.time = std::numeric_limits<float>::infinity();
+	limits.ply = std::max(1, std::min(depth - 1, control::max_ply));
+	limits.book = false;
+	auto result = bench_result{ 0, 0, 0 };
+	for (auto fen : bench_fens)
+	{
+		//each position searched on its own, the same way every run
+		ClearHash();
+		auto brd = board{};
+		auto color = white;
+		ParseFen(fen, brd, color);
+		auto last = search_info{};
+		StartPerfCounters();
+		GetBestMove(brd, color, boards{ brd }, limits, [&](const search_info& info)
+			{
+				last = info;
+			});
+		StopPerfCounters();
+		if (report) report(fen, last);
+		result.nodes += last.nodes;
+		result.time += last.time;
+		result.tree_allocations += TreeAllocations();
+	}
+	return result;
+}
+
+//uci name of a board index, row 0 of the board is rank 8
+auto SquareName(int index)
+{
+	return std::string{ char('a' + index % 8), char('0' + 8 - index / 8) };
+}
+
+//uci name of the move between two boards generated by the engine, like "e2e4" or "e7e8q"
+std::string MoveName(const board& before, const board& after)
+{
+	auto from = 0;
+	auto to = 0;
+	for (auto index = 0; index < 64; ++index)
+	{
+		if (before[index] == after[index]) continue;
+		if (after[index] == ' ') from = index;
+		else to = index;
+	}
+	auto name = SquareName(from) + SquareName(to);
+	if (before[from] != after[to]) name += char(std::tolower(after[to]));
+	return name;
+}
+
+//read piece placement and side to move of a fen, the engine does not track castling or en passant
+void ParseFen(const std::string& fen, board& brd, int& color)
+{
+	auto input = std::istringstream(fen);
+	auto placement = std::string{};
+	auto side = std::string{};
+	input >> placement >> side;
+	brd = board(64, ' ');
+	auto index = 0;
+	for (auto piece : placement)
+	{
+		if (piece == '/') continue;
+		if ('1' <= piece && piece <= '8') index += piece - '0';
+		else if (index < 64 && std::string("PNBRQKpnbrqk").find(piece) != std::string::npos) brd[index++] = piece;
+	}
+	color = (side == "b") ? black : white;
+}
+
+//fen of a board for the color to move
+std::string GetFen(const board& brd, int color)
+{
+	auto fen = std::string{};
+	for (auto row = 0; row < 8; ++row)
+	{
+		auto empty_squares = 0;
+		for (auto col = 0; col < 8; ++col)
+		{
+			auto piece = brd[row * 8 + col];
+			if (piece == ' ')
+			{
+				++empty_squares;
+				continue;
+			}
+			if (empty_squares != 0) fen += char('0' + empty_squares);
+			empty_squares = 0;
+			fen += piece;
+		}
+		if (empty_squares != 0) fen += char('0' + empty_squares);
+		if (row != 7) fen += '/';
+	}
+	fen += (color == white) ? " w " : " b ";
+
+	//castling rights while the king and rook are on their squares
+	auto castling = std::string{};
+	if (brd[60] == 'K' && brd[63] == 'R') castling += 'K';
+	if (brd[60] == 'K' && brd[56] == 'R') castling += 'Q';
+	if (brd[4] == 'k' && brd[7] == 'r') castling += 'k';
+	if (brd[4] == 'k' && brd[0] == 'r') castling += 'q';
+	return fen + (castling.empty() ? "-" : castling) + " - 0 1";
+}
+
+//give a pondering search its time limit, counted from now
+void PonderHit(float time)
+{
+	time_limit = Elapsed() + time;
+}
+
+//resize the transposition table, not while searching
+void SetHashSize(int mb)
+{
+	auto resize_trace = trace_scope("tt resize", "mb", mb);
+	//largest power of two entries that fits
+	auto entries = (std::size_t(std::max(mb, 1)) << 20) / sizeof(tt_entry);
+	auto size = std::size_t{ 1 };
+	while (size * 2 <= entries) size *= 2;
+	if (trans_table && size == trans_table_size)
+	{
+		//same size, cleared rather than allocated again
+		for (auto index = std::size_t{ 0 }; index < trans_table_size; ++index)
+		{
+			trans_table[index].key = 0;
+			trans_table[index].data = 0;
+		}
+		return;
+	}
+	trans_table_size = size;
+	trans_table.reset(new tt_entry[trans_table_size]());
+}
+
+//forget all search results, for a new game
+void ClearHash()
+{
+	InitSearch();
+	for (auto index = std::size_t{ 0 }; index < trans_table_size; ++index)
+	{
+		trans_table[index].key = 0;
+		trans_table[index].data = 0;
+	}
+	//cached scores may be from another evaluation
+	for (auto index = 0; index < control::eval_hash_size; ++index)
+	{
+		eval_table[index].key = 0;
+		eval_table[index].data = 0;
+	}
+	for (auto& thread : search_threads)
+	{
+		thread->killers = {};
+		thread->history = {};
+	}
+	expected::brd.clear();
+	search_age = 0;
+}
+
+//number of search threads, not while searching
+void SetThreads(int threads)
+{
+	threads = std::max(threads, 1);
+	while (static_cast<int>(search_threads.size()) > threads) search_threads.pop_back();
+	while (static_cast<int>(search_threads.size()) < threads) search_threads.emplace_back(new search_thread{});
+}
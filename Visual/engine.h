@@ -0,0 +1,187 @@
+/*
+    This header file contains the chess engine interface,
+    shared by the SFML game and the headless front-ends.
+*/
+
+#ifndef _ENGINE_H
+#define _ENGINE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//control paramaters
+namespace control {
+  const int max_ply             = 10;
+  const float max_time_per_move = 3;
+  const int max_chess_moves     = 218 / 2;
+  const int hash_size_mb        = 16;
+  const int eval_hash_size      = 1 << 16;
+  const int pawn_hash_size      = 1 << 14;
+  const int max_history         = 1 << 20;
+  const float info_interval     = 0.1f;
+  const int bench_depth         = 5;
+  const int perft_depth         = 5;
+  const int book_variety        = 50;
+  const char* const network_file  = "chesstogo.nnue";
+  const char* const book_file     = "chesstogo.bin";
+  const char* const explorer_file = "chesstogo.idx";
+  const char* const trace_file    = "chesstogo-trace.json";
+}
+
+//piece values, in centipawns
+namespace value_of {
+  const int king    = 20000;
+  const int queen   = 900;
+  const int rook    = 500;
+  const int bishop  = 330;
+  const int knight  = 320;
+  const int pawn    = 100;
+  const int mate    = king * 10;
+  const int tablebase_win = mate / 2;
+  const int timeout = mate * 2;
+}
+
+//board square/piece types
+const int white = 1;
+const int empty = 0;
+const int black = -1;
+
+//board is string of 64 chars
+typedef std::string board;
+typedef std::vector<board> boards;
+
+//evaluation score and board combination, with the move that produced the board,
+//material is the incrementally kept packed midgame and endgame material and position score from whites point of view,
+//phase the game phase the two are blended by, pawn_key the zobrist key of the pawns alone
+struct score_board
+{
+	int score;
+	int bias;
+	board brd;
+	int from;
+	int to;
+	char captured;
+	int order;
+	int material;
+	int phase;
+	std::uint64_t key;
+	std::uint64_t pawn_key;
+};
+typedef std::vector<score_board> score_boards;
+
+//limits for a single search, time is in seconds and may be infinite while pondering,
+//multi_pv is the number of best lines given exact scores, nodes the nodes each thread may search or 0 for no limit,
+//book false to search positions of the opening book and explorer as any other
+struct search_limits
+{
+	float time = control::max_time_per_move;
+	int ply = control::max_ply;
+	int multi_pv = 1;
+	std::uint64_t nodes = 0;
+	bool book = true;
+	const std::atomic<bool>* stop = nullptr;
+};
+
+//progress of a search, reported after each completed iteration for each of the multi_pv best lines
+struct search_info
+{
+	int depth;
+	int seldepth;
+	int score;
+	std::uint64_t nodes;
+	float time;
+	int hashfull;
+	boards pv;
+	int multi_pv;
+};
+typedef std::function<void(const search_info&)> info_callback;
+
+//test if king of given color is in check
+bool IsInCheck(const board& brd, int color, std::size_t& king_index);
+
+//evaluate (score) a board for the color given
+int GetEvaluation(const board& brd, int color);
+
+//boards for batch evaluation, stored square by square (structure of arrays) as one byte piece codes,
+//so the same square of many boards is scored at once
+struct board_batch
+{
+	std::array<std::vector<std::uint8_t>, 64> squares;
+	std::size_t size = 0;
+};
+
+//add a board to the end of a batch
+void AddToBatch(board_batch& batch, const board& brd);
+
+//evaluate (score) all boards of a batch for the color given, the same scores as GetEvaluation
+void GetEvaluations(const board_batch& batch, int color, std::vector<int>& scores);
+
+//generate all moves (boards) for the given colors turn
+score_boards GetAllMoves(const board& brd, int color);
+
+//count the leaf boards of all moves to a depth, a check of the move generator, without castling or en passant
+std::uint64_t Perft(const board& brd, int color, int depth);
+
+//best move for given board position for given color
+board GetBestMove(const board& brd, int color, const boards& history,
+	const search_limits& limits = search_limits{}, const info_callback& report = nullptr);
+
+//total of a bench run, the node count is the signature of the search, tree_allocations those below the roots
+//of the searches, counted in allocation tracking builds
+struct bench_result
+{
+	std::uint64_t nodes;
+	float time;
+	std::uint64_t tree_allocations;
+};
+
+//search the built-in bench positions to a depth on one thread with a cleared hash table of a size, reporting
+//the last iteration of each position, the same nodes every run for the same search, not while searching,
+//the threads and hash size are left as the bench set them, open performance counters count its searches only
+bench_result Bench(int depth, int hash_mb, const std::function<void(const std::string& fen, const search_info& info)>& report = nullptr);
+
+//uci name of the move between two boards generated by the engine, like "e2e4" or "e7e8q"
+std::string MoveName(const board& before, const board& after);
+
+//read piece placement and side to move of a fen, the engine does not track castling or en passant
+void ParseFen(const std::string& fen, board& brd, int& color);
+
+//fen of a board for the color to move, castling rights for the kings and rooks on their squares and no en passant
+std::string GetFen(const board& brd, int color);
+
+//give a pondering search its time limit, counted from now
+void PonderHit(float time);
+
+//resize the transposition table, not while searching
+void SetHashSize(int mb);
+
+//forget all search results, for a new game
+void ClearHash();
+
+//number of search threads, not while searching
+void SetThreads(int threads);
+
+//evaluate with the neural network in a network file, false and the piece square tables used if it can not be loaded,
+//not while searching
+bool LoadNetwork(const std::string& path);
+
+//probe the syzygy endgame tables in the directories of a path, separated by ':' (';' on windows),
+//the most pieces they cover returned, zero and no probing if none are found, not while searching
+int SetTablebasePath(const std::string& path);
+
+//play from the polyglot opening book of a book file while the position is in it, an empty path for none,
+//false if it can not be loaded, not while searching
+bool LoadBook(const std::string& path);
+
+//how widely book moves are picked, 0 only the heaviest up to 100 any in proportion to its weight
+void SetBookVariety(int variety);
+
+//order the first moves of the search by how often they were played in the games of a position index file,
+//an empty path for none, false if it can not be loaded, not while searching
+bool LoadExplorer(const std::string& path);
+
+#endif
@@ -0,0 +1,133 @@
+/*
+    This header file contains the engine internals, the move generation, evaluation and hash table primitives
+    engine.cpp keeps from the engine interface, declared for the other engine files and the tools measuring them
+    like the micro-benchmarks.
+*/
+
+#ifndef _ENGINE_INTERNAL_H
+#define _ENGINE_INTERNAL_H
+
+#include "engine.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//square contents are indexed directly by their char, dense tables replace maps keyed by piece
+const int piece_codes = 128;
+
+//fixed capacity list of up to 8 vectors, built at compile time
+template <typename T>
+struct vector_set
+{
+	std::array<T, 8> items;
+	int count;
+	constexpr const T* begin() const { return items.data(); }
+	constexpr const T* end() const { return items.data() + count; }
+};
+
+//description of a pieces movement and capture action
+struct move
+{
+	int dx;
+	int dy;
+	int length;
+	int flag;
+};
+typedef const vector_set<move> moves;
+
+//description of a pieces check influence
+struct vector
+{
+	int dx;
+	int dy;
+	int length;
+};
+
+typedef const vector_set<vector> vectors;
+
+//check test, array of pieces that must not be on this vectors from the king
+struct test
+{
+	std::string pieces;
+	vectors* check_vectors;
+};
+typedef const std::vector<test> tests;
+
+//transposition table bound types
+namespace bound {
+  const int exact = 0;
+  const int lower = 1;
+  const int upper = 2;
+}
+
+//move from/to squares and the piece landing on the to square
+struct tt_move
+{
+	std::int8_t from;
+	std::int8_t to;
+	char piece;
+};
+const auto no_move = tt_move{ -1, -1, ' ' };
+
+//unpacked transposition table data
+struct tt_data
+{
+	int score;
+	int ply;
+	int flag;
+	int age;
+	tt_move move;
+};
+
+//map board square contents to piece type/color, and piece to its movement possibilities
+extern const std::array<int, piece_codes> piece_type;
+extern const std::array<moves*, piece_codes> moves_map;
+
+//check tests of each king, piece types given can not be on the vectors given
+extern tests white_tests;
+extern tests black_tests;
+
+//bench positions, openings, middlegames, endgames and mates
+const int bench_positions = 50;
+extern const char* const bench_fens[bench_positions];
+
+//generate all first hit pieces from index position along given vectors
+std::string PieceScans(const board& brd, unsigned int index, const vectors& vectors);
+
+//packed material and position score of a board from whites point of view, its game phase and zobrist keys
+int GetMaterial(const board& brd);
+int GetPhase(const board& brd);
+std::uint64_t GetKey(const board& brd, int color);
+std::uint64_t GetPawnKey(const board& brd);
+
+//moves generated into a list kept for reuse, the first size boards are the moves, the boards after them and the scratch
+//board keep their storage so generating into the list again once it has grown does not allocate
+struct move_list
+{
+	score_boards boards;
+	std::size_t size = 0;
+	board scratch;
+	score_board* begin() { return boards.data(); }
+	score_board* end() { return boards.data() + size; }
+};
+
+//generate all boards for a piece index and moves possibility, filtering out boards where king is in check,
+//the board is changed in place and restored, child material, phase and keys are the parents plus the squares that changed
+void PieceMoves(move_list& yield, board& brd, unsigned int index, int color, const moves& moves, std::size_t& king_index,
+	int material, int phase, std::uint64_t key, std::uint64_t pawn_key);
+
+//generate all moves (boards) for the given colors turn from a generated board into a list, using its material, phase and keys
+void GenerateMoves(move_list& yield, const score_board& sbrd, int color);
+
+//generate all moves (boards) for the given colors turn from a generated board, using its material, phase and keys
+score_boards GetAllMoves(const score_board& sbrd, int color);
+
+//look up a key, false if not stored, and store a search result
+bool TTProbe(std::uint64_t key, tt_data& data);
+void TTStore(std::uint64_t key, int score, int ply, int flag, const tt_move& move);
+
+//create the hash table and main thread on first use
+void InitSearch();
+
+#endif
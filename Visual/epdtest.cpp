@@ -0,0 +1,243 @@
+/*
+    This code file contains the epd test suite runner, searching the positions of a suite like WAC or STS
+    and counting those where the engine finds a best move, in parallel over positions in worker processes.
+*/
+
+#include "engine.h"
+#include "pgn.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+//runner parameters
+namespace epdtest {
+  const int default_time_ms = 1000;
+  const int default_hash_mb = 16;
+}
+
+//a position of a suite, the moves to find (bm) or avoid (am) as the boards they play to
+struct epd_position
+{
+	std::string id;
+	std::string line;
+	board brd;
+	int color;
+	boards best;
+	boards avoid;
+	std::string moves;
+};
+
+//the outcome of searching a position, time and nodes to the solution are of the iteration
+//from which on the engine kept a solution, -1 if it did not end on one
+struct epd_result
+{
+	bool solved = false;
+	float time = -1;
+	std::uint64_t nodes = 0;
+	std::string move;
+};
+
+//the operands of an epd operation, quoted strings as one operand
+auto EpdOperands(const std::string& operation)
+{
+	auto operands = std::vector<std::string>{};
+	auto input = std::istringstream(operation);
+	auto operand = std::string{};
+	while (input >> std::ws && !input.eof())
+	{
+		if (input.peek() == '"')
+		{
+			input.get();
+			std::getline(input, operand, '"');
+		}
+		else input >> operand;
+		operands.push_back(operand);
+	}
+	return operands;
+}
+
+//read a position of an epd line, false if it has no position
+auto ParseEpd(const std::string& line, epd_position& position)
+{
+	auto input = std::istringstream(line);
+	auto placement = std::string{};
+	auto side = std::string{};
+	auto castling = std::string{};
+	auto en_passant = std::string{};
+	if (!(input >> placement >> side >> castling >> en_passant)) return false;
+	position = epd_position{};
+	position.line = line;
+	ParseFen(placement + " " + side, position.brd, position.color);
+
+	//operations, an opcode and its operands ended by ';'
+	auto operation = std::string{};
+	while (std::getline(input >> std::ws, operation, ';'))
+	{
+		auto operands = EpdOperands(operation);
+		if (operands.empty()) continue;
+		auto opcode = operands[0];
+		if (opcode == "id" && operands.size() > 1) position.id = operands[1];
+		if (opcode != "bm" && opcode != "am") continue;
+		for (auto san = begin(operands) + 1; san != end(operands); ++san)
+		{
+			auto move = san_move{};
+			if (!PlaySan(*san, position.brd, position.color, board{}, move)) continue;
+			(opcode == "bm" ? position.best : position.avoid).push_back(move.brd);
+			position.moves += (position.moves.empty() ? "" : " ") + opcode + " " + *san;
+		}
+	}
+	return true;
+}
+
+//test if a board played is a solution of a position
+auto IsSolution(const epd_position& position, const board& brd)
+{
+	auto is_in = [&](const boards& moves)
+		{
+			return std::find(begin(moves), end(moves), brd) != end(moves);
+		};
+	return (position.best.empty() || is_in(position.best)) && !is_in(position.avoid);
+}
+
+//search a position on its own, with the hash table cleared
+auto SearchEpd(const epd_position& position, const search_limits& limits)
+{
+	ClearHash();
+	auto result = epd_result{};
+	auto report = [&](const search_info& info)
+		{
+			if (info.multi_pv != 1 || info.pv.empty()) return;
+			if (!IsSolution(position, info.pv[0])) result.time = -1;
+			else if (result.time < 0)
+			{
+				result.time = info.time;
+				result.nodes = info.nodes;
+			}
+		};
+	auto best = GetBestMove(position.brd, position.color, boards{ position.brd }, limits, report);
+	result.solved = !best.empty() && IsSolution(position, best);
+	result.move = best.empty() ? std::string("none") : MoveName(position.brd, best);
+	if (!result.solved) result.time = -1;
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: chesstogo-epdtest <suite.epd> [-time " << epdtest::default_time_ms << " ms] [-nodes] [-depth] [-hash "
+			<< epdtest::default_hash_mb << " mb] [-threads]" << std::endl;
+		return 1;
+	}
+	auto limits = search_limits{};
+	limits.time = epdtest::default_time_ms / 1000.0f;
+	auto hash_mb = epdtest::default_hash_mb;
+	auto threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	auto worker = -1;
+	auto options = std::string{};
+	for (auto index = 2; index + 1 < argc; index += 2)
+	{
+		auto option = std::string(argv[index]);
+		auto value = std::atoll(argv[index + 1]);
+		if (option == "-time") limits.time = (value > 0) ? value / 1000.0f : std::numeric_limits<float>::infinity();
+		else if (option == "-nodes") limits.nodes = std::max(0LL, value);
+		else if (option == "-depth") limits.ply = std::max(1, std::min(static_cast<int>(value) - 1, control::max_ply));
+		else if (option == "-hash") hash_mb = std::max(1, static_cast<int>(value));
+		else if (option == "-threads") threads = std::max(1, static_cast<int>(value));
+		else if (option == "-worker") worker = static_cast<int>(value);
+		if (option != "-threads" && option != "-worker") options += " " + option + " " + argv[index + 1];
+	}
+	auto positions = std::vector<epd_position>{};
+	auto file = std::ifstream(argv[1]);
+	auto line = std::string{};
+	while (std::getline(file, line))
+	{
+		auto position = epd_position{};
+		if (!ParseEpd(line, position)) continue;
+		if (position.best.empty() && position.avoid.empty())
+		{
+			if (worker < 0) std::cerr << "no legal bm or am move, skipped " << line << std::endl;
+			continue;
+		}
+		if (position.id.empty()) position.id = "#" + std::to_string(positions.size() + 1);
+		positions.push_back(position);
+	}
+	if (positions.empty())
+	{
+		std::cerr << "no positions with a bm or am move in " << argv[1] << std::endl;
+		return 1;
+	}
+	LoadNetwork(control::network_file);
+	SetHashSize(hash_mb);
+	auto results = std::vector<epd_result>(positions.size());
+	if (worker >= 0)
+	{
+		//a worker searches every threads-th position from its own and reports each on a line
+		for (auto index = std::size_t(worker); index < positions.size(); index += threads)
+		{
+			auto result = SearchEpd(positions[index], limits);
+			std::cout << index << " " << result.solved << " " << result.time << " " << result.nodes << " " << result.move << std::endl;
+		}
+		return 0;
+	}
+	if (threads == 1)
+	{
+		for (auto index = std::size_t{ 0 }; index < positions.size(); ++index) results[index] = SearchEpd(positions[index], limits);
+	}
+	else
+	{
+		//the engine searches one position at a time, so positions are searched in parallel by worker processes
+		auto pipes = std::vector<FILE*>{};
+		for (auto index = 0; index < threads; ++index)
+		{
+			auto command = std::string("\"") + argv[0] + "\" \"" + argv[1] + "\"" + options + " -threads " + std::to_string(threads)
+				+ " -worker " + std::to_string(index);
+			pipes.push_back(popen(command.c_str(), "r"));
+		}
+		for (auto pipe : pipes)
+		{
+			if (!pipe) continue;
+			char text[256];
+			while (std::fgets(text, sizeof(text), pipe))
+			{
+				auto input = std::istringstream(text);
+				auto index = std::size_t{ 0 };
+				auto result = epd_result{};
+				if (input >> index >> result.solved >> result.time >> result.nodes >> result.move && index < results.size()) results[index] = result;
+			}
+			pclose(pipe);
+		}
+	}
+
+	//each position, then the solved count and the time and nodes to solve them
+	auto solved = 0;
+	auto total_time = 0.0;
+	auto total_nodes = std::uint64_t{ 0 };
+	for (auto index = std::size_t{ 0 }; index < positions.size(); ++index)
+	{
+		auto& position = positions[index];
+		auto& result = results[index];
+		std::cout << std::left << std::setw(12) << position.id << (result.solved ? " solved  " : " failed  ") << std::setw(6) << result.move
+			<< " " << position.moves;
+		if (result.solved) std::cout << " in " << result.time << "s " << result.nodes << " nodes";
+		std::cout << std::endl;
+		if (!result.solved) continue;
+		++solved;
+		total_time += result.time;
+		total_nodes += result.nodes;
+	}
+	std::cout << "solved " << solved << " of " << positions.size() << ", time to solve " << total_time << "s, nodes to solve "
+		<< total_nodes << std::endl;
+	return 0;
+}
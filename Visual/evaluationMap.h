@@ -0,0 +1,164 @@
+/*
+    This header file contains the evaluation weights, piece values and
+    piece square tables for the midgame and endgame, rewritten by the tune tool.
+*/
+
+#ifndef _EVALUATION_MAP_H
+#define _EVALUATION_MAP_H
+
+#include <array>
+
+//piece values in the midgame, in centipawns
+namespace midgame_value_of {
+  const int queen  = 900;
+  const int rook   = 500;
+  const int bishop = 330;
+  const int knight = 320;
+  const int pawn   = 100;
+}
+
+//piece values in the endgame, in centipawns
+namespace endgame_value_of {
+  const int queen  = 900;
+  const int rook   = 520;
+  const int bishop = 330;
+  const int knight = 290;
+  const int pawn   = 120;
+}
+
+//piece square tables, row 0 is rank 8 seen from white
+namespace evaluationMap {
+//pawn values for position in the midgame
+constexpr std::array<int, 64> pawn = {{
+	   0,   0,   0,   0,   0,   0,   0,   0,
+	  50,  50,  50,  50,  50,  50,  50,  50,
+	  10,  10,  20,  30,  30,  20,  10,  10,
+	   5,   5,  10,  25,  25,  10,   5,   5,
+	   0,   0,   0,  20,  20,   0,   0,   0,
+	   5,  -5, -10,   0,   0, -10,  -5,   5,
+	   5,  10,  10, -20, -20,  10,  10,   5,
+	   0,   0,   0,   0,   0,   0,   0,   0}};
+
+//knight values for position in the midgame
+constexpr std::array<int, 64> knight = {{
+	 -50, -40, -30, -30, -30, -30, -40, -50,
+	 -40, -20,   0,   0,   0,   0, -20, -40,
+	 -30,   0,  10,  15,  15,  10,   0, -30,
+	 -30,   5,  15,  20,  20,  15,   5, -30,
+	 -30,   0,  15,  20,  20,  15,   0, -30,
+	 -30,   5,  10,  15,  15,  10,   5, -30,
+	 -40, -20,   0,   5,   5,   0, -20, -40,
+	 -50, -40, -30, -30, -30, -30, -40, -50}};
+
+//bishop values for position in the midgame
+constexpr std::array<int, 64> bishop = {{
+	 -20, -10, -10, -10, -10, -10, -10, -20,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10,   0,   5,  10,  10,   5,   0, -10,
+	 -10,   5,   5,  10,  10,   5,   5, -10,
+	 -10,   0,  10,  10,  10,  10,   0, -10,
+	 -10,  10,  10,  10,  10,  10,  10, -10,
+	 -10,   5,   0,   0,   0,   0,   5, -10,
+	 -20, -10, -10, -10, -10, -10, -10, -20}};
+
+//rook values for position in the midgame
+constexpr std::array<int, 64> rook = {{
+	   0,   0,   0,   0,   0,   0,   0,   0,
+	   5,  10,  10,  10,  10,  10,  10,   5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	   0,   0,   0,   5,   5,   0,   0,   0}};
+
+//queen values for position in the midgame
+constexpr std::array<int, 64> queen = {{
+	 -20, -10, -10,  -5,  -5, -10, -10, -20,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10,   0,   5,   5,   5,   5,   0, -10,
+	  -5,   0,   5,   5,   5,   5,   0,  -5,
+	   0,   0,   5,   5,   5,   5,   0,  -5,
+	 -10,   5,   5,   5,   5,   5,   0, -10,
+	 -10,   0,   5,   0,   0,   0,   0, -10,
+	 -20, -10, -10,  -5,  -5, -10, -10, -20}};
+
+//king values for position in the midgame
+constexpr std::array<int, 64> king = {{
+	 -30, -40, -40, -50, -50, -40, -40, -30,
+	 -30, -40, -40, -50, -50, -40, -40, -30,
+	 -30, -40, -40, -50, -50, -40, -40, -30,
+	 -30, -40, -40, -50, -50, -40, -40, -30,
+	 -20, -30, -30, -40, -40, -30, -30, -20,
+	 -10, -20, -20, -20, -20, -20, -20, -10,
+	  20,  20,   0,   0,   0,   0,  20,  20,
+	  20,  30,  10,   0,   0,  10,  30,  20}};
+
+//pawn values for position in the endgame
+constexpr std::array<int, 64> pawn_endgame = {{
+	   0,   0,   0,   0,   0,   0,   0,   0,
+	  80,  80,  80,  80,  80,  80,  80,  80,
+	  50,  50,  50,  50,  50,  50,  50,  50,
+	  30,  30,  30,  30,  30,  30,  30,  30,
+	  20,  20,  20,  20,  20,  20,  20,  20,
+	  10,  10,  10,  10,  10,  10,  10,  10,
+	   0,   0,   0,   0,   0,   0,   0,   0,
+	   0,   0,   0,   0,   0,   0,   0,   0}};
+
+//knight values for position in the endgame
+constexpr std::array<int, 64> knight_endgame = {{
+	 -50, -40, -30, -30, -30, -30, -40, -50,
+	 -40, -20,   0,   0,   0,   0, -20, -40,
+	 -30,   0,  10,  15,  15,  10,   0, -30,
+	 -30,   5,  15,  20,  20,  15,   5, -30,
+	 -30,   0,  15,  20,  20,  15,   0, -30,
+	 -30,   5,  10,  15,  15,  10,   5, -30,
+	 -40, -20,   0,   5,   5,   0, -20, -40,
+	 -50, -40, -30, -30, -30, -30, -40, -50}};
+
+//bishop values for position in the endgame
+constexpr std::array<int, 64> bishop_endgame = {{
+	 -20, -10, -10, -10, -10, -10, -10, -20,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10,   0,   5,  10,  10,   5,   0, -10,
+	 -10,   5,   5,  10,  10,   5,   5, -10,
+	 -10,   0,  10,  10,  10,  10,   0, -10,
+	 -10,  10,  10,  10,  10,  10,  10, -10,
+	 -10,   5,   0,   0,   0,   0,   5, -10,
+	 -20, -10, -10, -10, -10, -10, -10, -20}};
+
+//rook values for position in the endgame
+constexpr std::array<int, 64> rook_endgame = {{
+	   0,   0,   0,   0,   0,   0,   0,   0,
+	   5,  10,  10,  10,  10,  10,  10,   5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	  -5,   0,   0,   0,   0,   0,   0,  -5,
+	   0,   0,   0,   5,   5,   0,   0,   0}};
+
+//queen values for position in the endgame
+constexpr std::array<int, 64> queen_endgame = {{
+	 -20, -10, -10,  -5,  -5, -10, -10, -20,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10,   0,   5,   5,   5,   5,   0, -10,
+	  -5,   0,   5,   5,   5,   5,   0,  -5,
+	   0,   0,   5,   5,   5,   5,   0,  -5,
+	 -10,   5,   5,   5,   5,   5,   0, -10,
+	 -10,   0,   5,   0,   0,   0,   0, -10,
+	 -20, -10, -10,  -5,  -5, -10, -10, -20}};
+
+//king values for position in the endgame
+constexpr std::array<int, 64> king_endgame = {{
+	 -50, -40, -30, -20, -20, -30, -40, -50,
+	 -30, -20, -10,   0,   0, -10, -20, -30,
+	 -30, -10,  20,  30,  30,  20, -10, -30,
+	 -30, -10,  30,  40,  40,  30, -10, -30,
+	 -30, -10,  30,  40,  40,  30, -10, -30,
+	 -30, -10,  20,  30,  30,  20, -10, -30,
+	 -30, -30,   0,   0,   0,   0, -30, -30,
+	 -50, -30, -30, -30, -30, -30, -30, -50}};
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    This code file contains the opening explorer declared in explorer.h,
+    a binary search of the mapped position index with no copies made.
+*/
+
+#include "explorer.h"
+#include "book.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cstring>
+
+//the mapped index and its tables
+auto explorer_file = mapped_file{};
+auto explorer_header = index_header{};
+const index_position* index_positions = nullptr;
+const index_move* index_moves = nullptr;
+const std::uint32_t* index_games = nullptr;
+
+//explore the position index file of a path, an empty path for none
+bool LoadExplorer(const std::string& path)
+{
+	explorer_file = path.empty() ? mapped_file{} : mapped_file(path);
+	explorer_header = index_header{};
+	index_positions = nullptr;
+	index_moves = nullptr;
+	index_games = nullptr;
+	if (explorer_file.size() < sizeof(index_header)) return false;
+
+	//the tables must fill the file exactly
+	auto header = index_header{};
+	std::memcpy(&header, explorer_file.data(), sizeof(header));
+	auto size = sizeof(index_header) + header.positions * sizeof(index_position) + header.moves * sizeof(index_move)
+		+ header.games * sizeof(std::uint32_t);
+	if (std::memcmp(header.magic, position_index::magic, sizeof(header.magic)) != 0 || size != explorer_file.size())
+	{
+		explorer_file = mapped_file{};
+		return false;
+	}
+	explorer_header = header;
+	auto data = explorer_file.data() + sizeof(index_header);
+	index_positions = reinterpret_cast<const index_position*>(data);
+	index_moves = reinterpret_cast<const index_move*>(index_positions + header.positions);
+	index_games = reinterpret_cast<const std::uint32_t*>(index_moves + header.moves);
+	return true;
+}
+
+//find a position of the index by its polyglot key
+bool ExplorePosition(std::uint64_t key, explored_position& found)
+{
+	auto last = index_positions + explorer_header.positions;
+	auto position = std::lower_bound(index_positions, last, key, [](const index_position& position, std::uint64_t key)
+		{
+			return position.key < key;
+		});
+	if (position == last || position->key != key) return false;
+	found = explored_position{ position, index_moves + position->first_move, index_games + position->first_game };
+	return true;
+}
+
+//find a board of the index for the color to move
+bool ExplorePosition(const board& brd, int color, const boards& history, explored_position& found)
+{
+	if (explorer_file.empty()) return false;
+	return ExplorePosition(PolyglotKey(brd, color, history), found);
+}
+
+//order generated boards that were played in the games first, most played first
+void ExplorerOrder(const board& brd, int color, const boards& history, score_boards& next_boards)
+{
+	auto found = explored_position{};
+	if (!ExplorePosition(brd, color, history, found)) return;
+	auto played = [&](const score_board& sbrd)
+		{
+			auto move = PolyglotMove(brd, sbrd);
+			auto index_move = std::find_if(found.moves, found.moves + found.position->moves, [&](const auto& played)
+				{
+					return played.move == move;
+				});
+			return static_cast<std::uint32_t>(index_move - found.moves);
+		};
+	std::stable_sort(begin(next_boards), end(next_boards), [&](const auto& brd1, const auto& brd2)
+		{
+			return played(brd1) < played(brd2);
+		});
+}
@@ -0,0 +1,80 @@
+/*
+    This header file contains the opening explorer, a position index of a game database
+    memory mapped and searched by the polyglot key of a board (see book.h).
+*/
+
+#ifndef _EXPLORER_H
+#define _EXPLORER_H
+
+#include <cstdint>
+#include <string>
+#include "engine.h"
+
+//position index file layout, native byte order:
+//  index_header
+//  index_position[positions]   sorted by key
+//  index_move[moves]           the moves played from each position, most played first
+//  uint32[games]               the games reaching each position, by their order in the pgn files
+namespace position_index {
+  const char magic[8] = "CTGIDX1";
+}
+
+struct index_header
+{
+	char magic[8];
+	std::uint64_t positions;
+	std::uint64_t moves;
+	std::uint64_t games;
+};
+
+//a position played from in the games, results for the color to move counted once per game,
+//games without a result count in games but not in the results
+struct index_position
+{
+	std::uint64_t key;
+	std::uint64_t first_move;
+	std::uint64_t first_game;
+	std::uint32_t moves;
+	std::uint32_t games;
+	std::uint32_t wins;
+	std::uint32_t draws;
+	std::uint32_t losses;
+	std::uint32_t unused;
+};
+
+//a move played from a position, polyglot encoded, counted once per time it was played with the results
+//for the color that played it
+struct index_move
+{
+	std::uint16_t move;
+	std::uint16_t unused;
+	std::uint32_t games;
+	std::uint32_t wins;
+	std::uint32_t draws;
+	std::uint32_t losses;
+};
+
+static_assert(sizeof(index_header) == 32 && sizeof(index_position) == 48 && sizeof(index_move) == 20, "index layout");
+
+//a position found in the index, views into the mapped file
+struct explored_position
+{
+	const index_position* position;
+	const index_move* moves;
+	const std::uint32_t* games;
+};
+
+//explore the position index file of a path, an empty path for none, false if it can not be mapped,
+//not while searching
+bool LoadExplorer(const std::string& path);
+
+//find a position of the index by its polyglot key, false if no game reached it
+bool ExplorePosition(std::uint64_t key, explored_position& found);
+
+//find a board of the index for the color to move, the history is the boards played up to it
+bool ExplorePosition(const board& brd, int color, const boards& history, explored_position& found);
+
+//order generated boards that were played in the games first, most played first, the rest keeping their order
+void ExplorerOrder(const board& brd, int color, const boards& history, score_boards& next_boards);
+
+#endif
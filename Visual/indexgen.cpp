@@ -0,0 +1,243 @@
+/*
+    This code file contains the position index builder, the games of pgn files indexed by the positions
+    they played from for the opening explorer (see explorer.h).
+*/
+
+#include "book.h"
+#include "explorer.h"
+#include "mappedFile.h"
+#include "pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+//builder parameters, the shards split the keys by their top bits so the shards in order are the keys in order
+namespace indexgen {
+  const int default_plies = 40;
+  const int shard_bits    = 8;
+  const int shards        = 1 << shard_bits;
+  const std::size_t chunk = 1 << 20;
+}
+
+//a move played from a position in a game, the game numbered within its chunk until the chunks are counted,
+//the result for the color to move
+struct position_record
+{
+	std::uint64_t key;
+	std::uint32_t game;
+	std::uint16_t move;
+	std::int16_t result;
+};
+
+//index order, by key, then game so each game of a key is counted once
+auto RecordBefore(const position_record& record1, const position_record& record2)
+{
+	return record1.key < record2.key || (record1.key == record2.key && record1.game < record2.game);
+}
+
+//the records of a chunk by shard and how many games it has
+struct chunk_records
+{
+	std::vector<std::vector<position_record>> shards;
+	std::uint32_t games = 0;
+	std::uint64_t moves = 0;
+	std::uint64_t illegal = 0;
+};
+
+//the index tables of a shard, offsets within the shard
+struct shard_index
+{
+	std::vector<index_position> positions;
+	std::vector<index_move> moves;
+	std::vector<std::uint32_t> games;
+};
+
+//record the moves of the games in a range of a pgn text, up to the ply limit
+auto RecordGames(const char* first, const char* last, int plies, chunk_records& records)
+{
+	records.shards.resize(indexgen::shards);
+	auto position = first;
+	auto game = pgn_game{};
+	while (NextGame(position, last, game))
+	{
+		auto legal = PlayGame(game, plies, [&](const board& brd, int color, const boards& history, const san_move& move)
+			{
+				auto key = PolyglotKey(brd, color, history);
+				auto result = (game.result == pgn_result::unknown) ? pgn_result::unknown : game.result * color;
+				records.shards[key >> (64 - indexgen::shard_bits)].push_back(position_record{ key, records.games,
+					PolyglotMove(move.from, move.to, move.promotion), static_cast<std::int16_t>(result) });
+				++records.moves;
+			});
+		if (!legal) ++records.illegal;
+		++records.games;
+	}
+}
+
+//add a result to the counts of a position or move
+template<typename counts>
+auto AddResult(counts& count, int result)
+{
+	if (result == pgn_result::unknown) return;
+	if (result > 0) ++count.wins;
+	else if (result < 0) ++count.losses;
+	else ++count.draws;
+}
+
+//index the sorted records of a shard, the moves of each position most played first
+auto IndexShard(const std::vector<position_record>& records, shard_index& index)
+{
+	for (auto first = std::size_t{ 0 }; first < records.size();)
+	{
+		auto last = first;
+		while (last < records.size() && records[last].key == records[first].key) ++last;
+		auto position = index_position{ records[first].key, index.moves.size(), index.games.size(), 0, 0, 0, 0, 0, 0 };
+		auto first_move = index.moves.size();
+		for (auto record = first; record < last; ++record)
+		{
+			auto& played = records[record];
+			if (record == first || records[record - 1].game != played.game)
+			{
+				index.games.push_back(played.game);
+				AddResult(position, played.result);
+			}
+			auto move = std::find_if(begin(index.moves) + first_move, end(index.moves), [&](const auto& move)
+				{
+					return move.move == played.move;
+				});
+			if (move == end(index.moves)) move = index.moves.insert(move, index_move{ played.move, 0, 0, 0, 0, 0 });
+			++move->games;
+			AddResult(*move, played.result);
+		}
+		std::sort(begin(index.moves) + first_move, end(index.moves), [](const auto& move1, const auto& move2)
+			{
+				return move1.games > move2.games || (move1.games == move2.games && move1.move < move2.move);
+			});
+		position.moves = static_cast<std::uint32_t>(index.moves.size() - first_move);
+		position.games = static_cast<std::uint32_t>(index.games.size() - position.first_game);
+		index.positions.push_back(position);
+		first = last;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "usage: chesstogo-indexgen <index.idx> <games.pgn>... [-plies " << indexgen::default_plies << "] [-threads]" << std::endl;
+		return 1;
+	}
+	auto output = std::string(argv[1]);
+	auto plies = indexgen::default_plies;
+	auto threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	auto inputs = std::vector<std::string>{};
+	for (auto index = 2; index < argc; ++index)
+	{
+		auto option = std::string(argv[index]);
+		auto value = (index + 1 < argc) ? std::atoi(argv[index + 1]) : 0;
+		if (option == "-plies") plies = std::max(1, value);
+		else if (option == "-threads") threads = std::max(1, value);
+		else
+		{
+			inputs.push_back(option);
+			continue;
+		}
+		++index;
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	//the games split into chunks at game starts, taken by the threads in turn
+	auto files = std::vector<mapped_file>{};
+	auto chunks = std::vector<std::pair<const char*, const char*>>{};
+	for (auto& input : inputs)
+	{
+		files.emplace_back(input);
+		auto& file = files.back();
+		if (file.empty())
+		{
+			std::cerr << "could not read " << input << std::endl;
+			return 1;
+		}
+		auto first = reinterpret_cast<const char*>(file.data());
+		auto ranges = SplitGames(first, first + file.size(), indexgen::chunk);
+		chunks.insert(end(chunks), begin(ranges), end(ranges));
+	}
+	auto RunThreads = [&](auto work)
+		{
+			auto helpers = std::vector<std::thread>{};
+			for (auto thread = 1; thread < threads; ++thread) helpers.emplace_back(work);
+			work();
+			for (auto& helper : helpers) helper.join();
+		};
+	auto records = std::vector<chunk_records>(chunks.size());
+	auto next_chunk = std::atomic<std::size_t>{ 0 };
+	RunThreads([&]()
+		{
+			for (auto index = next_chunk++; index < chunks.size(); index = next_chunk++)
+			{
+				RecordGames(chunks[index].first, chunks[index].second, plies, records[index]);
+			}
+		});
+
+	//games numbered in the order of the files, then each shard gathered from the chunks, sorted and indexed
+	auto games = std::uint32_t{ 0 };
+	auto moves = std::uint64_t{ 0 };
+	auto illegal = std::uint64_t{ 0 };
+	auto game_offsets = std::vector<std::uint32_t>{};
+	for (auto& chunk : records)
+	{
+		game_offsets.push_back(games);
+		games += chunk.games;
+		moves += chunk.moves;
+		illegal += chunk.illegal;
+	}
+	auto indexes = std::vector<shard_index>(indexgen::shards);
+	auto next_shard = std::atomic<int>{ 0 };
+	RunThreads([&]()
+		{
+			for (auto shard = next_shard++; shard < indexgen::shards; shard = next_shard++)
+			{
+				auto shard_records = std::vector<position_record>{};
+				for (auto chunk = std::size_t{ 0 }; chunk < records.size(); ++chunk)
+				{
+					auto& chunk_shard = records[chunk].shards[shard];
+					for (auto& record : chunk_shard) shard_records.push_back(position_record{ record.key, record.game + game_offsets[chunk], record.move, record.result });
+					chunk_shard = {};
+				}
+				std::sort(begin(shard_records), end(shard_records), RecordBefore);
+				IndexShard(shard_records, indexes[shard]);
+			}
+		});
+
+	//the tables of the shards one after another, their offsets moved past the shards before
+	auto header = index_header{};
+	std::copy(std::begin(position_index::magic), std::end(position_index::magic), header.magic);
+	for (auto& index : indexes)
+	{
+		for (auto& position : index.positions)
+		{
+			position.first_move += header.moves;
+			position.first_game += header.games;
+		}
+		header.positions += index.positions.size();
+		header.moves += index.moves.size();
+		header.games += index.games.size();
+	}
+	auto file = std::ofstream(output, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (auto& index : indexes) file.write(reinterpret_cast<const char*>(index.positions.data()), index.positions.size() * sizeof(index_position));
+	for (auto& index : indexes) file.write(reinterpret_cast<const char*>(index.moves.data()), index.moves.size() * sizeof(index_move));
+	for (auto& index : indexes) file.write(reinterpret_cast<const char*>(index.games.data()), index.games.size() * sizeof(std::uint32_t));
+	if (!file)
+	{
+		std::cerr << "could not write " << output << std::endl;
+		return 1;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << games << " games (" << illegal << " cut short at an illegal move), " << moves << " moves, " << header.positions
+		<< " positions in " << output << ", " << elapsed.count() << "s" << std::endl;
+	return 0;
+}
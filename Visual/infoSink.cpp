@@ -0,0 +1,125 @@
+/*
+    This code file contains member functions of infoSink.h
+*/
+
+#include "infoSink.h"
+#include <algorithm>
+#include <cstdlib>
+
+//uci score, mate scores carry the remaining ply of the mated node, so convert to moves from the root
+auto ScoreName(const search_info& info)
+{
+	if (info.score >= value_of::mate)
+	{
+		auto plies = info.depth - (info.score - value_of::mate);
+		return "mate " + std::to_string((plies + 1) / 2);
+	}
+	if (info.score <= -value_of::mate)
+	{
+		//mate 0 for the side to move already mated
+		auto plies = info.depth - (-info.score - value_of::mate);
+		return (plies / 2 == 0) ? std::string("mate 0") : "mate -" + std::to_string(plies / 2);
+	}
+	return "cp " + std::to_string(info.score);
+}
+
+//uci info line for a search from the root board, "info depth .. pv .."
+std::string InfoLine(const board& root, const search_info& info)
+{
+	auto line = "info depth " + std::to_string(info.depth) + " seldepth " + std::to_string(info.seldepth)
+		+ " multipv " + std::to_string(info.multi_pv) + " score " + ScoreName(info)
+		+ " nodes " + std::to_string(info.nodes)
+		+ " nps " + std::to_string(static_cast<std::uint64_t>(info.nodes / std::max(info.time, 0.001f)))
+		+ " hashfull " + std::to_string(info.hashfull)
+		+ " time " + std::to_string(static_cast<int>(info.time * 1000)) + " pv";
+	auto before = root;
+	for (auto& after : info.pv)
+	{
+		line += " " + MoveName(before, after);
+		before = after;
+	}
+	return line;
+}
+
+info_sink::info_sink(std::ostream& out, float interval)
+: out(out), interval(interval), urgent(false), stopping(false)
+{
+	writer = std::thread(&info_sink::Run, this);
+}
+
+info_sink::~info_sink()
+{
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	writer.join();
+	Flush();
+}
+
+info_callback info_sink::Reporter(const board& root)
+{
+	return [this, root](const search_info& info)
+	{
+		Post(info.multi_pv, InfoLine(root, info));
+	};
+}
+
+void info_sink::Post(int slot, const std::string& line)
+{
+	std::lock_guard<std::mutex> lock(state_mutex);
+	latest[slot] = line;
+}
+
+void info_sink::Send(const std::string& line)
+{
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		buffer += Collect();
+		buffer += line;
+		buffer += '\n';
+		urgent = true;
+	}
+	wake.notify_one();
+}
+
+void info_sink::Flush()
+{
+	std::lock_guard<std::mutex> write_lock(write_mutex);
+	auto text = std::string{};
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		text.swap(buffer);
+		text += Collect();
+	}
+	if (!text.empty()) out << text << std::flush;
+}
+
+//newest lines of each slot in slot order, the caller holds the state mutex
+std::string info_sink::Collect()
+{
+	auto text = std::string{};
+	for (auto& slot : latest)
+	{
+		text += slot.second;
+		text += '\n';
+	}
+	latest.clear();
+	return text;
+}
+
+//writer thread, waking once per interval or when a line is sent
+void info_sink::Run()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(state_mutex);
+			wake.wait_for(lock, interval, [this]() { return urgent || stopping; });
+			urgent = false;
+			if (stopping) return;
+		}
+		Flush();
+	}
+}
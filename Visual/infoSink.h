@@ -0,0 +1,57 @@
+/*
+    This header file contains the info_sink class,
+    buffered and rate limited output of search progress.
+*/
+
+#ifndef _INFO_SINK_H
+#define _INFO_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "engine.h"
+
+//uci info line for a search from the root board, "info depth .. pv .."
+std::string InfoLine(const board& root, const search_info& info);
+
+//search threads only format and queue their lines, a writer thread flushes them at most once per interval,
+//keeping just the newest line of each multi pv slot, so reporting never waits on the output
+class info_sink
+{
+public:
+	info_sink(std::ostream& out, float interval = control::info_interval);
+	~info_sink();
+
+	//callback for GetBestMove, reporting a search from the root board
+	info_callback Reporter(const board& root);
+
+	//queue the newest line of a multi pv slot, replacing one not yet written
+	void Post(int slot, const std::string& line);
+
+	//queue a line after everything posted so far and write it without waiting for the interval
+	void Send(const std::string& line);
+
+	//write everything queued now, from the calling thread
+	void Flush();
+
+private:
+	std::string Collect();
+	void Run();
+
+	std::ostream& out;
+	std::chrono::duration<float> interval;
+	std::mutex state_mutex;
+	std::mutex write_mutex;
+	std::condition_variable wake;
+	std::string buffer;
+	std::map<int, std::string> latest;
+	bool urgent;
+	bool stopping;
+	std::thread writer;
+};
+
+#endif
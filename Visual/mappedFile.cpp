@@ -0,0 +1,110 @@
+/*
+    This code file contains member functions of mappedFile.h
+*/
+
+#include "mappedFile.h"
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::string& path)
+{
+	auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+	auto file_size = LARGE_INTEGER{};
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return;
+	}
+	auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return;
+	}
+	auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+	file_handle = file;
+	mapping_handle = mapping;
+	bytes = static_cast<const unsigned char*>(view);
+	length = static_cast<std::size_t>(file_size.QuadPart);
+}
+
+void mapped_file::Close()
+{
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping_handle) CloseHandle(mapping_handle);
+	if (file_handle) CloseHandle(file_handle);
+	bytes = nullptr;
+	length = 0;
+	file_handle = nullptr;
+	mapping_handle = nullptr;
+}
+
+#else
+
+mapped_file::mapped_file(const std::string& path)
+{
+	auto file = open(path.c_str(), O_RDONLY);
+	if (file < 0) return;
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		return;
+	}
+	auto view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+	//the mapping keeps the file alive on its own
+	close(file);
+	if (view == MAP_FAILED) return;
+	bytes = static_cast<const unsigned char*>(view);
+	length = static_cast<std::size_t>(status.st_size);
+}
+
+void mapped_file::Close()
+{
+	if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+	bytes = nullptr;
+	length = 0;
+}
+
+#endif
+
+mapped_file::~mapped_file()
+{
+	Close();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+	if (this == &other) return *this;
+	Close();
+	std::swap(bytes, other.bytes);
+	std::swap(length, other.length);
+#ifdef _WIN32
+	std::swap(file_handle, other.file_handle);
+	std::swap(mapping_handle, other.mapping_handle);
+#endif
+	return *this;
+}
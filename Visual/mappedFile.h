@@ -0,0 +1,41 @@
+/*
+    This header file contains the mapped_file class,
+    a read only memory mapping of a whole data file.
+*/
+
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+//the file contents are paged in by the os as they are read and shared between processes,
+//an empty mapping if the file can not be opened
+class mapped_file
+{
+public:
+	mapped_file() = default;
+	explicit mapped_file(const std::string& path);
+	~mapped_file();
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	mapped_file(mapped_file&& other) noexcept;
+	mapped_file& operator=(mapped_file&& other) noexcept;
+
+	const unsigned char* data() const { return bytes; }
+	std::size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+
+private:
+	void Close();
+
+	const unsigned char* bytes = nullptr;
+	std::size_t length = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+#endif
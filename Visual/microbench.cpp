@@ -0,0 +1,310 @@
+/*
+    This code file contains the micro-benchmarks of the engine primitives, each timed over the bench positions
+    in repetitions and reported in nanoseconds per operation, as a table or as json to compare between commits.
+    It reaches the primitives the engine keeps to itself through the engine internals header.
+*/
+
+#include "engineInternal.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+//benchmark parameters, each repetition runs passes over the corpus for at least the minimum time
+namespace microbench {
+  const int default_repetitions = 10;
+  const float min_time          = 0.05f;
+  const int tt_keys             = 1 << 16;
+}
+
+//a position of the corpus with its moves, a generated board as the search sees it
+struct corpus_position
+{
+	score_board sbrd;
+	int color;
+	score_boards moves;
+};
+
+//a primitive timed, one pass over the corpus returning the operations it did
+struct micro_benchmark
+{
+	const char* name;
+	std::function<std::uint64_t()> pass;
+};
+
+//nanoseconds per operation of the repetitions of a benchmark
+struct micro_result
+{
+	std::string name;
+	std::uint64_t ops;
+	std::vector<double> ns_per_op;
+};
+
+//results of the primitives summed so the compiler can not drop the work
+auto sink = std::uint64_t{ 0 };
+
+//the bench positions, each as a generated board with its moves
+auto MakeCorpus()
+{
+	auto corpus = std::vector<corpus_position>{};
+	for (auto fen : bench_fens)
+	{
+		auto brd = board{};
+		auto color = white;
+		ParseFen(fen, brd, color);
+		auto sbrd = score_board{ 0, 0, brd, -1, -1, ' ', 0, GetMaterial(brd), GetPhase(brd), GetKey(brd, color), GetPawnKey(brd) };
+		corpus.push_back(corpus_position{ sbrd, color, GetAllMoves(sbrd, color) });
+	}
+	return corpus;
+}
+
+//the primitives, each over the whole corpus
+auto MakeBenchmarks(const std::vector<corpus_position>& corpus)
+{
+	auto benchmarks = std::vector<micro_benchmark>{};
+	benchmarks.push_back({ "PieceScans", [&]()
+		{
+			//the check scans from both kings
+			auto ops = std::uint64_t{ 0 };
+			for (auto& position : corpus)
+			{
+				for (auto king : { 'K', 'k' })
+				{
+					auto index = static_cast<unsigned int>(position.sbrd.brd.find(king));
+					if (index >= 64) continue;
+					for (auto& test : (king == 'K') ? white_tests : black_tests)
+					{
+						sink += PieceScans(position.sbrd.brd, index, *test.check_vectors).size();
+						++ops;
+					}
+				}
+			}
+			return ops;
+		} });
+	benchmarks.push_back({ "IsInCheck", [&]()
+		{
+			auto ops = std::uint64_t{ 0 };
+			for (auto& position : corpus)
+			{
+				for (auto color : { white, black })
+				{
+					std::size_t king_index = 0;
+					sink += IsInCheck(position.sbrd.brd, color, king_index);
+					++ops;
+				}
+			}
+			return ops;
+		} });
+	benchmarks.push_back({ "GetEvaluation", [&]()
+		{
+			auto ops = std::uint64_t{ 0 };
+			for (auto& position : corpus)
+			{
+				sink += GetEvaluation(position.sbrd.brd, position.color);
+				++ops;
+			}
+			return ops;
+		} });
+	benchmarks.push_back({ "PieceMoves", [&]()
+		{
+			//the moves of each piece of the color to move, into one list reused as the search does
+			auto ops = std::uint64_t{ 0 };
+			static auto yield = move_list{};
+			for (auto& position : corpus)
+			{
+				auto brd = position.sbrd.brd;
+				std::size_t king_index = 0;
+				for (auto index = 0u; index < 64; ++index)
+				{
+					auto piece = brd[index];
+					if (piece == ' ' || piece_type[piece] != position.color) continue;
+					yield.size = 0;
+					PieceMoves(yield, brd, index, position.color, *moves_map[piece], king_index, position.sbrd.material, position.sbrd.phase,
+						position.sbrd.key, position.sbrd.pawn_key);
+					sink += yield.size;
+					++ops;
+				}
+			}
+			return ops;
+		} });
+	benchmarks.push_back({ "GetAllMoves", [&]()
+		{
+			auto ops = std::uint64_t{ 0 };
+			for (auto& position : corpus)
+			{
+				sink += GetAllMoves(position.sbrd, position.color).size();
+				++ops;
+			}
+			return ops;
+		} });
+	benchmarks.push_back({ "TTStore", [&]()
+		{
+			static auto keys = std::vector<std::uint64_t>{};
+			if (keys.empty())
+			{
+				auto random = std::mt19937_64(1);
+				for (auto index = 0; index < microbench::tt_keys; ++index) keys.push_back(random());
+			}
+			for (auto key : keys) TTStore(key, static_cast<int>(key & 1023), static_cast<int>(key >> 60), bound::exact, no_move);
+			return static_cast<std::uint64_t>(keys.size());
+		} });
+	benchmarks.push_back({ "TTProbe", [&]()
+		{
+			//the keys of the moves of the corpus, stored before timing so about half of the probes hit
+			static auto keys = std::vector<std::uint64_t>{};
+			if (keys.empty())
+			{
+				for (auto& position : corpus)
+				{
+					for (auto& move : position.moves) keys.push_back(move.key);
+				}
+				for (auto index = std::size_t{ 0 }; index < keys.size(); index += 2) TTStore(keys[index], 0, 1, bound::exact, no_move);
+			}
+			auto data = tt_data{};
+			for (auto key : keys) sink += TTProbe(key, data);
+			return static_cast<std::uint64_t>(keys.size());
+		} });
+	benchmarks.push_back({ "MakeUnmake", [&]()
+		{
+			//each move played on the board in place and taken back, as the move generator does
+			auto ops = std::uint64_t{ 0 };
+			for (auto& position : corpus)
+			{
+				auto brd = position.sbrd.brd;
+				for (auto& move : position.moves)
+				{
+					auto piece = brd[move.from];
+					brd[move.from] = ' ';
+					brd[move.to] = move.brd[move.to];
+					sink += static_cast<unsigned char>(brd[move.to]);
+					brd[move.from] = piece;
+					brd[move.to] = move.captured;
+					++ops;
+				}
+			}
+			return ops;
+		} });
+	benchmarks.push_back({ "CopyMake", [&]()
+		{
+			//each move played on a copy of the generated board, as the search makes its children
+			auto ops = std::uint64_t{ 0 };
+			for (auto& position : corpus)
+			{
+				for (auto& move : position.moves)
+				{
+					auto child = position.sbrd;
+					child.brd[move.from] = ' ';
+					child.brd[move.to] = move.brd[move.to];
+					child.key = move.key;
+					sink += static_cast<unsigned char>(child.brd[move.to]);
+					++ops;
+				}
+			}
+			return ops;
+		} });
+	return benchmarks;
+}
+
+//time a benchmark, passes enough for the minimum time per repetition
+auto RunBenchmark(const micro_benchmark& benchmark, int repetitions)
+{
+	auto Seconds = [](auto start)
+		{
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			return elapsed.count();
+		};
+	auto result = micro_result{ benchmark.name, 0, {} };
+	auto passes = 1;
+	for (;;)
+	{
+		//warm up and calibrate
+		auto start = std::chrono::steady_clock::now();
+		for (auto pass = 0; pass < passes; ++pass) benchmark.pass();
+		if (Seconds(start) >= microbench::min_time) break;
+		passes *= 2;
+	}
+	for (auto repetition = 0; repetition < repetitions; ++repetition)
+	{
+		auto ops = std::uint64_t{ 0 };
+		auto start = std::chrono::steady_clock::now();
+		for (auto pass = 0; pass < passes; ++pass) ops += benchmark.pass();
+		result.ns_per_op.push_back(Seconds(start) * 1e9 / ops);
+		result.ops = ops;
+	}
+	return result;
+}
+
+//minimum, median, mean and standard deviation of the repetitions
+auto Statistics(std::vector<double> values)
+{
+	std::sort(begin(values), end(values));
+	auto mean = 0.0;
+	for (auto value : values) mean += value;
+	mean /= values.size();
+	auto variance = 0.0;
+	for (auto value : values) variance += (value - mean) * (value - mean);
+	auto median = (values.size() % 2 == 1) ? values[values.size() / 2] : (values[values.size() / 2 - 1] + values[values.size() / 2]) / 2;
+	return std::array<double, 4>{ values.front(), median, mean, std::sqrt(variance / values.size()) };
+}
+
+//results as json, a benchmark per entry
+auto WriteJson(std::ostream& output, const std::vector<micro_result>& results, int repetitions)
+{
+	output << std::fixed << std::setprecision(3);
+	output << "{\n  \"positions\": " << bench_positions << ",\n  \"repetitions\": " << repetitions << ",\n  \"benchmarks\": [\n";
+	for (auto index = std::size_t{ 0 }; index < results.size(); ++index)
+	{
+		auto& result = results[index];
+		auto statistics = Statistics(result.ns_per_op);
+		output << "    { \"name\": \"" << result.name << "\", \"ops_per_repetition\": " << result.ops << ", \"ns_per_op\": { \"min\": "
+			<< statistics[0] << ", \"median\": " << statistics[1] << ", \"mean\": " << statistics[2] << ", \"stddev\": " << statistics[3]
+			<< " } }" << (index + 1 < results.size() ? "," : "") << "\n";
+	}
+	output << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+	auto repetitions = microbench::default_repetitions;
+	auto json = std::string{};
+	auto filter = std::string{};
+	for (auto index = 1; index + 1 < argc; index += 2)
+	{
+		auto option = std::string(argv[index]);
+		if (option == "-repetitions") repetitions = std::max(1, std::atoi(argv[index + 1]));
+		else if (option == "-json") json = argv[index + 1];
+		else if (option == "-filter") filter = argv[index + 1];
+		else
+		{
+			std::cerr << "usage: chesstogo-microbench [-repetitions " << microbench::default_repetitions
+				<< "] [-json <file> | -] [-filter <name part>]" << std::endl;
+			return 1;
+		}
+	}
+	LoadNetwork(control::network_file);
+	InitSearch();
+	auto corpus = MakeCorpus();
+	auto results = std::vector<micro_result>{};
+	for (auto& benchmark : MakeBenchmarks(corpus))
+	{
+		if (std::string(benchmark.name).find(filter) == std::string::npos) continue;
+		results.push_back(RunBenchmark(benchmark, repetitions));
+		if (json == "-") continue;
+		auto statistics = Statistics(results.back().ns_per_op);
+		std::cout << std::left << std::setw(16) << benchmark.name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << statistics[1] << " ns/op median" << std::setw(10) << statistics[0] << " min" << std::setw(8)
+			<< statistics[3] << " stddev" << std::endl;
+	}
+	if (json == "-") WriteJson(std::cout, results, repetitions);
+	else if (!json.empty())
+	{
+		auto file = std::ofstream(json);
+		WriteJson(file, results, repetitions);
+	}
+	return 0;
+}
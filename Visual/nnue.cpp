@@ -0,0 +1,285 @@
+/*
+    This code file contains the neural network evaluation declared in nnue.h,
+    with AVX2 and SSE4.1 paths picked at compile time and a plain fallback.
+*/
+
+#include "nnue.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+const char network_magic[] = "CTGNNUE1";
+const std::size_t network_magic_size = sizeof(network_magic) - 1;
+
+//network weights, the feature weights are read straight from the mapped file,
+//the small layers are copied out aligned
+struct network
+{
+	mapped_file file;
+	const std::int16_t* feature_biases;
+	const std::int16_t* feature_weights;
+	alignas(64) std::array<std::int32_t, nnue::hidden> hidden_biases;
+	alignas(64) std::array<std::array<std::int8_t, 2 * nnue::accumulated>, nnue::hidden> hidden_weights;
+	std::int32_t output_bias;
+	alignas(64) std::array<std::int8_t, nnue::hidden> output_weights;
+};
+auto loaded_network = std::unique_ptr<network>{};
+
+//size of a network file
+constexpr std::size_t NetworkFileSize()
+{
+	return network_magic_size
+		+ sizeof(std::int16_t) * nnue::accumulated
+		+ sizeof(std::int16_t) * nnue::features * nnue::accumulated
+		+ sizeof(std::int32_t) * nnue::hidden
+		+ sizeof(std::int8_t) * nnue::hidden * 2 * nnue::accumulated
+		+ sizeof(std::int32_t)
+		+ sizeof(std::int8_t) * nnue::hidden;
+}
+
+//map a network file, false and the piece square tables kept if it is missing or not a network
+bool LoadNetwork(const std::string& path)
+{
+	loaded_network.reset();
+	auto file = mapped_file(path);
+	if (file.size() != NetworkFileSize() || std::memcmp(file.data(), network_magic, network_magic_size) != 0) return false;
+	auto loading = std::unique_ptr<network>(new network{});
+	auto read = file.data() + network_magic_size;
+	loading->feature_biases = reinterpret_cast<const std::int16_t*>(read);
+	read += sizeof(std::int16_t) * nnue::accumulated;
+	loading->feature_weights = reinterpret_cast<const std::int16_t*>(read);
+	read += sizeof(std::int16_t) * nnue::features * nnue::accumulated;
+	std::memcpy(loading->hidden_biases.data(), read, sizeof(loading->hidden_biases));
+	read += sizeof(loading->hidden_biases);
+	std::memcpy(loading->hidden_weights.data(), read, sizeof(loading->hidden_weights));
+	read += sizeof(loading->hidden_weights);
+	std::memcpy(&loading->output_bias, read, sizeof(loading->output_bias));
+	read += sizeof(loading->output_bias);
+	std::memcpy(loading->output_weights.data(), read, sizeof(loading->output_weights));
+	loading->file = std::move(file);
+	loaded_network = std::move(loading);
+	return true;
+}
+
+//test if the search evaluates with a network
+bool NetworkLoaded()
+{
+	return loaded_network != nullptr;
+}
+
+//test if the network can evaluate a board, with both kings on it
+bool NetworkEvaluates(const board& brd)
+{
+	return NetworkLoaded() && brd.find('K') != board::npos && brd.find('k') != board::npos;
+}
+
+//piece kind of each piece seen from white, none for kings and empty squares
+constexpr auto MakePieceKinds()
+{
+	auto kinds = std::array<int, 128>{};
+	for (auto& kind : kinds) kind = -1;
+	kinds['P'] = 0; kinds['N'] = 1; kinds['B'] = 2; kinds['R'] = 3; kinds['Q'] = 4;
+	kinds['p'] = 5; kinds['n'] = 6; kinds['b'] = 7; kinds['r'] = 8; kinds['q'] = 9;
+	return kinds;
+}
+constexpr auto piece_kind = MakePieceKinds();
+
+//accumulator side of each color, and the flip of board indexes seen from that side
+const int white_side = 0;
+const int black_side = 1;
+const int side_flip[2] = { 0, 56 };
+
+//feature of a piece on a board index seen from a side with its king on the given (flipped) square, -1 if none
+auto Feature(int side, int king_square, char piece, int index)
+{
+	auto kind = piece_kind[piece];
+	if (kind < 0) return -1;
+	if (side == black_side) kind = (kind + nnue::piece_kinds / 2) % nnue::piece_kinds;
+	return (king_square * nnue::piece_kinds + kind) * 64 + (index ^ side_flip[side]);
+}
+
+//copy a side accumulator taking away and adding feature weights, one register width at a time
+auto AccumulateFeatures(const std::int16_t* before, std::int16_t* after, const int* removed, int removed_count,
+	const int* added, int added_count)
+{
+	auto weights = loaded_network->feature_weights;
+#if defined(__AVX2__)
+	for (auto offset = 0; offset < nnue::accumulated; offset += 16)
+	{
+		auto sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(before + offset));
+		for (auto index = 0; index < removed_count; ++index)
+		{
+			sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + removed[index] * nnue::accumulated + offset)));
+		}
+		for (auto index = 0; index < added_count; ++index)
+		{
+			sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + added[index] * nnue::accumulated + offset)));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(after + offset), sum);
+	}
+#elif defined(__SSE4_1__)
+	for (auto offset = 0; offset < nnue::accumulated; offset += 8)
+	{
+		auto sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(before + offset));
+		for (auto index = 0; index < removed_count; ++index)
+		{
+			sum = _mm_sub_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + removed[index] * nnue::accumulated + offset)));
+		}
+		for (auto index = 0; index < added_count; ++index)
+		{
+			sum = _mm_add_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + added[index] * nnue::accumulated + offset)));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(after + offset), sum);
+	}
+#else
+	if (before != after) std::copy(before, before + nnue::accumulated, after);
+	for (auto index = 0; index < removed_count; ++index)
+	{
+		auto row = weights + removed[index] * nnue::accumulated;
+		for (auto offset = 0; offset < nnue::accumulated; ++offset) after[offset] -= row[offset];
+	}
+	for (auto index = 0; index < added_count; ++index)
+	{
+		auto row = weights + added[index] * nnue::accumulated;
+		for (auto offset = 0; offset < nnue::accumulated; ++offset) after[offset] += row[offset];
+	}
+#endif
+}
+
+//accumulator side of a board from scratch
+auto RefreshSide(const board& brd, int side, std::array<std::int16_t, nnue::accumulated>& values)
+{
+	auto king_square = int(brd.find(side == white_side ? 'K' : 'k')) ^ side_flip[side];
+	int added[32] = {};
+	auto added_count = 0;
+	for (auto index = 0; index < 64; ++index)
+	{
+		auto feature = Feature(side, king_square, brd[index], index);
+		if (feature >= 0 && added_count < 32) added[added_count++] = feature;
+	}
+	AccumulateFeatures(loaded_network->feature_biases, values.data(), nullptr, 0, added, added_count);
+}
+
+//accumulator of a board from scratch
+void RefreshAccumulator(const board& brd, nnue_accumulator& accumulator)
+{
+	RefreshSide(brd, white_side, accumulator.sides[white_side]);
+	RefreshSide(brd, black_side, accumulator.sides[black_side]);
+}
+
+//accumulator of a board generated from another by moving from one square to another, from the accumulator before,
+//a side whose own king moved has all its features change so it is refreshed
+void UpdateAccumulator(const nnue_accumulator& before_accumulator, const board& before, const board& after, int from, int to,
+	nnue_accumulator& accumulator)
+{
+	auto moved = before[from];
+	for (auto side : { white_side, black_side })
+	{
+		auto king = (side == white_side) ? 'K' : 'k';
+		if (moved == king)
+		{
+			RefreshSide(after, side, accumulator.sides[side]);
+			continue;
+		}
+		auto king_square = int(after.find(king)) ^ side_flip[side];
+		int removed[2] = {};
+		auto removed_count = 0;
+		int added[1] = {};
+		auto added_count = 0;
+		auto feature = Feature(side, king_square, moved, from);
+		if (feature >= 0) removed[removed_count++] = feature;
+		feature = Feature(side, king_square, before[to], to);
+		if (feature >= 0) removed[removed_count++] = feature;
+		feature = Feature(side, king_square, after[to], to);
+		if (feature >= 0) added[added_count++] = feature;
+		AccumulateFeatures(before_accumulator.sides[side].data(), accumulator.sides[side].data(), removed, removed_count, added, added_count);
+	}
+}
+
+//clipped activation of a side accumulator into bytes 0..activation
+auto Activate(const std::array<std::int16_t, nnue::accumulated>& values, std::uint8_t* output)
+{
+#if defined(__AVX2__)
+	const auto zero = _mm256_setzero_si256();
+	for (auto offset = 0; offset < nnue::accumulated; offset += 32)
+	{
+		auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values.data() + offset));
+		auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values.data() + offset + 16));
+		//pack saturates to -128..127, the lanes come out interleaved
+		auto packed = _mm256_max_epi8(_mm256_packs_epi16(low, high), zero);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + offset), _mm256_permute4x64_epi64(packed, 0xD8));
+	}
+#elif defined(__SSE4_1__)
+	const auto zero = _mm_setzero_si128();
+	for (auto offset = 0; offset < nnue::accumulated; offset += 16)
+	{
+		auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values.data() + offset));
+		auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values.data() + offset + 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + offset), _mm_max_epi8(_mm_packs_epi16(low, high), zero));
+	}
+#else
+	for (auto offset = 0; offset < nnue::accumulated; ++offset)
+	{
+		output[offset] = static_cast<std::uint8_t>(std::min(std::max(int(values[offset]), 0), nnue::activation));
+	}
+#endif
+}
+
+//dot product of activated bytes and int8 weights, no 16 bit sum can saturate as activations are at most 127
+auto Dot(const std::uint8_t* input, const std::int8_t* weights, int size)
+{
+#if defined(__AVX2__)
+	const auto ones = _mm256_set1_epi16(1);
+	auto sum = _mm256_setzero_si256();
+	for (auto offset = 0; offset < size; offset += 32)
+	{
+		auto products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + offset)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + offset)));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+	}
+	auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+	return _mm_cvtsi128_si32(half);
+#elif defined(__SSE4_1__)
+	const auto ones = _mm_set1_epi16(1);
+	auto sum = _mm_setzero_si128();
+	for (auto offset = 0; offset < size; offset += 16)
+	{
+		auto products = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + offset)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + offset)));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return _mm_cvtsi128_si32(sum);
+#else
+	auto sum = 0;
+	for (auto offset = 0; offset < size; ++offset) sum += int(input[offset]) * int(weights[offset]);
+	return sum;
+#endif
+}
+
+//evaluate (score) an accumulated board for the color given
+int NetworkEvaluation(const nnue_accumulator& accumulator, int color)
+{
+	auto& net = *loaded_network;
+	auto us = (color == white) ? white_side : black_side;
+	alignas(64) std::uint8_t input[2 * nnue::accumulated];
+	Activate(accumulator.sides[us], input);
+	Activate(accumulator.sides[1 - us], input + nnue::accumulated);
+	auto output = net.output_bias;
+	for (auto index = 0; index < nnue::hidden; ++index)
+	{
+		auto sum = net.hidden_biases[index] + Dot(input, net.hidden_weights[index].data(), 2 * nnue::accumulated);
+		output += std::min(std::max(sum >> nnue::hidden_shift, 0), nnue::activation) * net.output_weights[index];
+	}
+	return std::min(std::max(output / nnue::output_scale, -value_of::king), value_of::king);
+}
@@ -0,0 +1,63 @@
+/*
+    This header file contains the neural network evaluation,
+    an efficiently updatable network used by the engine in place of
+    the piece square tables when a network file is loaded.
+*/
+
+#ifndef _NNUE_H
+#define _NNUE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "engine.h"
+
+//network shape, half king piece features per side into the accumulator, both sides into one hidden layer
+namespace nnue {
+  const int piece_kinds  = 10;
+  const int features     = 64 * piece_kinds * 64;
+  const int accumulated  = 256;
+  const int hidden       = 32;
+  const int activation   = 127;
+  const int hidden_shift = 6;
+  const int output_scale = 16;
+}
+
+//network file layout, little endian, the size must match exactly:
+//  8 bytes     "CTGNNUE1"
+//  int16       feature biases[accumulated]
+//  int16       feature weights[features][accumulated]
+//  int32       hidden biases[hidden]
+//  int8        hidden weights[hidden][2 * accumulated], side to move first
+//  int32       output bias
+//  int8        output weights[hidden]
+//a feature is (king square * piece_kinds + piece kind) * 64 + square, squares are board indexes seen from the side,
+//flipped top to bottom for black, piece kinds are pnbrq of the side then of the opponent, kings are not features
+
+//accumulated feature weights of a board for white and black, the first layer before activation
+struct alignas(64) nnue_accumulator
+{
+	std::array<std::array<std::int16_t, nnue::accumulated>, 2> sides;
+};
+
+//map a network file, false and the piece square tables kept if it is missing or not a network
+bool LoadNetwork(const std::string& path);
+
+//test if the search evaluates with a network
+bool NetworkLoaded();
+
+//test if the network can evaluate a board, its features are relative to the kings so both must be on it,
+//the boards searched from it keep them
+bool NetworkEvaluates(const board& brd);
+
+//accumulator of a board from scratch
+void RefreshAccumulator(const board& brd, nnue_accumulator& accumulator);
+
+//accumulator of a board generated from another by moving from one square to another, from the accumulator before
+void UpdateAccumulator(const nnue_accumulator& before_accumulator, const board& before, const board& after, int from, int to,
+	nnue_accumulator& accumulator);
+
+//evaluate (score) an accumulated board for the color given
+int NetworkEvaluation(const nnue_accumulator& accumulator, int color);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+    This code file contains the hardware performance counters declared in perfCounters.h,
+    Linux perf events opened when built with CHESSTOGO_PERF_COUNTERS.
+*/
+
+#include "perfCounters.h"
+
+#if defined(CHESSTOGO_PERF_COUNTERS) && defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//an open counter per event, -1 if it is not open
+auto perf_descriptors = std::array<int, perf_events>{ -1, -1, -1, -1, -1, -1 };
+
+//perf event type and config of a cache miss on reads
+constexpr std::uint64_t CacheReadMisses(std::uint64_t cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+//perf event type and config of each event
+const std::array<std::array<std::uint64_t, 2>, perf_events> perf_configs = { {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, CacheReadMisses(PERF_COUNT_HW_CACHE_L1D) },
+	{ PERF_TYPE_HW_CACHE, CacheReadMisses(PERF_COUNT_HW_CACHE_LL) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_HW_CACHE, CacheReadMisses(PERF_COUNT_HW_CACHE_DTLB) },
+} };
+
+//a counter of user space of this thread and its new threads, stopped
+auto OpenPerfCounter(const std::array<std::uint64_t, 2>& config)
+{
+	auto attributes = perf_event_attr{};
+	std::memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.type = static_cast<std::uint32_t>(config[0]);
+	attributes.config = config[1];
+	attributes.disabled = 1;
+	attributes.inherit = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+//test if this is a performance counter build
+bool CountsPerfEvents()
+{
+	return true;
+}
+
+//open the counters, stopped and zero
+bool OpenPerfCounters()
+{
+	auto opened = false;
+	for (auto event = 0; event < perf_events; ++event)
+	{
+		if (perf_descriptors[event] < 0) perf_descriptors[event] = OpenPerfCounter(perf_configs[event]);
+		if (perf_descriptors[event] < 0) continue;
+		ioctl(perf_descriptors[event], PERF_EVENT_IOC_RESET, 0);
+		opened = true;
+	}
+	return opened;
+}
+
+//start counting
+void StartPerfCounters()
+{
+	for (auto descriptor : perf_descriptors)
+	{
+		if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+//stop counting
+void StopPerfCounters()
+{
+	for (auto descriptor : perf_descriptors)
+	{
+		if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+	}
+}
+
+//counts since the counters were opened, then close them
+perf_counts ClosePerfCounters()
+{
+	auto result = perf_counts{};
+	for (auto event = 0; event < perf_events; ++event)
+	{
+		auto& descriptor = perf_descriptors[event];
+		if (descriptor < 0) continue;
+
+		//the count, the time the event was enabled and the time it was on a counter
+		std::uint64_t values[3] = {};
+		if (read(descriptor, values, sizeof(values)) == sizeof(values) && values[2] > 0)
+		{
+			result.counts[event] = static_cast<std::uint64_t>(double(values[0]) * values[1] / values[2]);
+			result.counted[event] = true;
+		}
+		close(descriptor);
+		descriptor = -1;
+	}
+	return result;
+}
+
+#else
+
+//test if this is a performance counter build
+bool CountsPerfEvents()
+{
+	return false;
+}
+
+//open the counters, none without perf events
+bool OpenPerfCounters()
+{
+	return false;
+}
+
+//start counting
+void StartPerfCounters()
+{
+}
+
+//stop counting
+void StopPerfCounters()
+{
+}
+
+//counts since the counters were opened, none without perf events
+perf_counts ClosePerfCounters()
+{
+	return perf_counts{};
+}
+
+#endif
@@ -0,0 +1,37 @@
+/*
+    This header file contains the hardware performance counters, Linux perf_event_open counters of cycles,
+    instructions and cache, branch and TLB misses, counting only while started in performance counter builds.
+*/
+
+#ifndef _PERF_COUNTERS_H
+#define _PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+
+//hardware events counted
+enum perf_event { perf_cycles, perf_instructions, perf_l1_misses, perf_llc_misses, perf_branch_misses, perf_dtlb_misses, perf_events };
+
+//counts of the events while the counters were started, scaled up when the cpu shared its counters between events,
+//an event not counted if this cpu or kernel does not have it
+struct perf_counts
+{
+	std::array<std::uint64_t, perf_events> counts;
+	std::array<bool, perf_events> counted;
+};
+
+//test if this is a performance counter build, the counters never open otherwise
+bool CountsPerfEvents();
+
+//open the counters of this thread and the threads it starts from now on, stopped and zero,
+//false if none could be opened, like without access to perf events
+bool OpenPerfCounters();
+
+//start or stop counting, nothing if the counters are not open
+void StartPerfCounters();
+void StopPerfCounters();
+
+//counts since the counters were opened, then close them
+perf_counts ClosePerfCounters();
+
+#endif
@@ -0,0 +1,302 @@
+/*
+    This code file contains the pgn reading declared in pgn.h,
+    a single pass over the text with no copies, and san moves matched against the generated moves.
+*/
+
+#include "pgn.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+//test for the white space between pgn tokens
+auto IsPgnSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//first position from position on that is not white space
+auto SkipPgnSpace(const char* position, const char* last)
+{
+	while (position < last && IsPgnSpace(*position)) ++position;
+	return position;
+}
+
+//position just past a character from position on, last if it is not there
+auto SkipPast(const char* position, const char* last, char c)
+{
+	auto found = static_cast<const char*>(std::memchr(position, c, last - position));
+	return found ? found + 1 : last;
+}
+
+//result of a result tag value or game termination marker
+auto ResultOf(std::string_view text)
+{
+	if (text == "1-0") return pgn_result::white_won;
+	if (text == "0-1") return pgn_result::black_won;
+	if (text == "1/2-1/2") return pgn_result::draw;
+	return pgn_result::unknown;
+}
+
+//length of the game termination marker at a position of the movetext, 0 if there is none
+auto TerminationLength(const char* position, const char* first, const char* last)
+{
+	if (position != first && !IsPgnSpace(position[-1])) return 0;
+	for (auto marker : { std::string_view("1-0"), std::string_view("0-1"), std::string_view("1/2-1/2"), std::string_view("*") })
+	{
+		auto end = position + marker.size();
+		if (end <= last && std::string_view(position, marker.size()) == marker && (end == last || IsPgnSpace(*end)))
+		{
+			return static_cast<int>(marker.size());
+		}
+	}
+	return 0;
+}
+
+//start of the first game at or after a position of a pgn text
+const char* NextGameStart(const char* position, const char* first, const char* last)
+{
+	for (auto at = position; at < last; ++at)
+	{
+		at = static_cast<const char*>(std::memchr(at, '[', last - at));
+		if (!at) return last;
+		if (at == first) return at;
+		if (at[-1] != '\n') continue;
+
+		//the line before must be empty
+		auto before = at - 1;
+		while (before > first && (before[-1] == ' ' || before[-1] == '\t' || before[-1] == '\r')) --before;
+		if (before == first || before[-1] == '\n') return at;
+	}
+	return last;
+}
+
+//split a pgn text into ranges of about a size that start at games
+std::vector<std::pair<const char*, const char*>> SplitGames(const char* first, const char* last, std::size_t size)
+{
+	auto ranges = std::vector<std::pair<const char*, const char*>>{};
+	for (auto range = first; range < last;)
+	{
+		auto next = (std::size_t(last - range) > size) ? NextGameStart(range + size, first, last) : last;
+		ranges.emplace_back(range, next);
+		range = next;
+	}
+	return ranges;
+}
+
+//read the next game of a pgn text from position, which is moved past it
+bool NextGame(const char*& position, const char* last, pgn_game& game)
+{
+	game = pgn_game{ std::string_view{}, std::string_view{}, pgn_result::unknown };
+	auto at = SkipPgnSpace(position, last);
+	if (at == last)
+	{
+		position = last;
+		return false;
+	}
+
+	//tag pairs, a line each
+	auto tag_result = pgn_result::unknown;
+	while (at < last && *at == '[')
+	{
+		auto line_end = SkipPast(at, last, '\n');
+		auto line = std::string_view(at, line_end - at);
+		auto name = line.substr(1, line.find_first_of(" \t\"]") - 1);
+		auto open = line.find('"');
+		auto close = line.rfind('"');
+		auto value = (open != std::string_view::npos && close > open) ? line.substr(open + 1, close - open - 1) : std::string_view{};
+		if (name == "FEN") game.fen = value;
+		else if (name == "Result") tag_result = ResultOf(value);
+		at = SkipPgnSpace(line_end, last);
+	}
+
+	//movetext up to the game termination marker, or up to the next game if it has none
+	auto movetext = at;
+	while (at < last)
+	{
+		if (*at == '{')
+		{
+			at = SkipPast(at, last, '}');
+			continue;
+		}
+		if (*at == ';')
+		{
+			at = SkipPast(at, last, '\n');
+			continue;
+		}
+		if (*at == '[' && at != movetext && at[-1] == '\n') break;
+		auto length = TerminationLength(at, movetext, last);
+		if (length != 0)
+		{
+			game.movetext = std::string_view(movetext, at - movetext);
+			game.result = ResultOf(std::string_view(at, length));
+			if (game.result == pgn_result::unknown) game.result = tag_result;
+			position = at + length;
+			return true;
+		}
+		++at;
+	}
+	game.movetext = std::string_view(movetext, at - movetext);
+	game.result = tag_result;
+	position = at;
+	return true;
+}
+
+//take the next san move off the front of a movetext
+bool NextSan(std::string_view& movetext, std::string_view& san)
+{
+	while (!movetext.empty())
+	{
+		auto c = movetext.front();
+		if (IsPgnSpace(c) || c == '.')
+		{
+			movetext.remove_prefix(1);
+			continue;
+		}
+		if (c == '{' || c == ';')
+		{
+			//comment up to its end
+			auto end = movetext.find(c == '{' ? '}' : '\n');
+			movetext.remove_prefix(end == std::string_view::npos ? movetext.size() : end + 1);
+			continue;
+		}
+		if (c == '(')
+		{
+			//variation up to its matching end, with the comments in it
+			auto depth = 0;
+			auto index = std::size_t{ 0 };
+			for (; index < movetext.size(); ++index)
+			{
+				if (movetext[index] == '{') index = std::min(movetext.find('}', index), movetext.size() - 1);
+				else if (movetext[index] == '(') ++depth;
+				else if (movetext[index] == ')' && --depth == 0) break;
+			}
+			movetext.remove_prefix(std::min(index + 1, movetext.size()));
+			continue;
+		}
+		auto length = std::min(movetext.find_first_of(" \t\r\n{};()$"), movetext.size());
+		if (c == '$')
+		{
+			//numeric annotation glyph
+			length = 1;
+			while (length < movetext.size() && std::isdigit(static_cast<unsigned char>(movetext[length]))) ++length;
+		}
+		auto token = movetext.substr(0, std::max(length, std::size_t{ 1 }));
+		if (c == '$' || c == ')' || c == '}' || ResultOf(token) != pgn_result::unknown || token == "*"
+			|| token.find_first_not_of("!?") == std::string_view::npos || token == "e.p.")
+		{
+			movetext.remove_prefix(token.size());
+			continue;
+		}
+		if (std::isdigit(static_cast<unsigned char>(c)) && token.substr(0, 3) != "0-0")
+		{
+			//move number, the move may follow its dots without a space
+			auto digits = token.find_first_not_of("0123456789");
+			movetext.remove_prefix(digits == std::string_view::npos ? token.size() : digits);
+			continue;
+		}
+		san = token;
+		movetext.remove_prefix(token.size());
+		return true;
+	}
+	return false;
+}
+
+//piece letter of a color, white uppercase
+auto SanPiece(char piece, int color)
+{
+	return (color == white) ? piece : static_cast<char>(std::tolower(piece));
+}
+
+//play a san move on a board for the color to move
+bool PlaySan(std::string_view san, const board& brd, int color, const board& previous, san_move& move)
+{
+	while (!san.empty() && std::string_view("+#!?").find(san.back()) != std::string_view::npos) san.remove_suffix(1);
+	auto home = (color == white) ? 56 : 0;
+	if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+	{
+		//king and rook on their squares with the squares between them empty
+		auto queen_side = san.size() == 5;
+		auto king = home + 4;
+		auto rook = home + (queen_side ? 0 : 7);
+		if (brd[king] != SanPiece('K', color) || brd[rook] != SanPiece('R', color)) return false;
+		for (auto index = std::min(king, rook) + 1; index < std::max(king, rook); ++index)
+		{
+			if (brd[index] != ' ') return false;
+		}
+		move = san_move{ brd, king, rook, ' ' };
+		move.brd[king] = move.brd[rook] = ' ';
+		move.brd[home + (queen_side ? 2 : 6)] = SanPiece('K', color);
+		move.brd[home + (queen_side ? 3 : 5)] = SanPiece('R', color);
+		return true;
+	}
+
+	//piece, disambiguation, capture, destination and promotion
+	auto piece = (!san.empty() && std::string_view("NBRQK").find(san.front()) != std::string_view::npos) ? san.front() : 'P';
+	if (piece != 'P') san.remove_prefix(1);
+	auto promotion = ' ';
+	if (piece == 'P' && !san.empty() && std::string_view("NBRQ").find(san.back()) != std::string_view::npos)
+	{
+		promotion = san.back();
+		san.remove_suffix(1);
+		if (!san.empty() && san.back() == '=') san.remove_suffix(1);
+	}
+	if (san.size() < 2) return false;
+	auto file = san[san.size() - 2] - 'a';
+	auto rank = san[san.size() - 1] - '1';
+	if (file < 0 || file > 7 || rank < 0 || rank > 7) return false;
+	auto to = (7 - rank) * 8 + file;
+	auto from_file = -1;
+	auto from_row = -1;
+	auto capture = false;
+	for (auto c : san.substr(0, san.size() - 2))
+	{
+		if ('a' <= c && c <= 'h') from_file = c - 'a';
+		else if ('1' <= c && c <= '8') from_row = 7 - (c - '1');
+		else if (c == 'x' || c == ':') capture = true;
+		else return false;
+	}
+	for (auto& sbrd : GetAllMoves(brd, color))
+	{
+		if (sbrd.to != to || brd[sbrd.from] != SanPiece(piece, color)) continue;
+		if ((from_file >= 0 && sbrd.from % 8 != from_file) || (from_row >= 0 && sbrd.from / 8 != from_row)) continue;
+		auto promoted = (sbrd.brd[to] != brd[sbrd.from]) ? static_cast<char>(std::toupper(sbrd.brd[to])) : ' ';
+		if (promoted != promotion) continue;
+		move = san_move{ sbrd.brd, sbrd.from, to, promotion };
+		return true;
+	}
+
+	//en passant, the pawn taken stands beside the pawn taking it after a double step
+	auto step = (color == white) ? 8 : -8;
+	auto taken = to + step;
+	auto from = (from_file >= 0 && std::abs(from_file - file) == 1) ? taken - file + from_file : -1;
+	if (piece != 'P' || !capture || from < 0 || brd[to] != ' ' || brd[from] != SanPiece('P', color)
+		|| brd[taken] != SanPiece('P', -color)) return false;
+	if (!previous.empty() && (previous[taken] != ' ' || previous[to - step] != SanPiece('P', -color))) return false;
+	move = san_move{ brd, from, to, ' ' };
+	move.brd[from] = move.brd[taken] = ' ';
+	move.brd[to] = SanPiece('P', color);
+	return true;
+}
+
+//play a game from its start up to a ply limit visiting each move
+bool PlayGame(const pgn_game& game, int plies, const game_visitor& visit)
+{
+	auto brd = board("rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR");
+	auto color = white;
+	if (!game.fen.empty()) ParseFen(std::string(game.fen), brd, color);
+	auto history = boards{ brd };
+	auto movetext = game.movetext;
+	auto san = std::string_view{};
+	auto move = san_move{};
+	for (auto ply = 0; ply < plies && NextSan(movetext, san); ++ply)
+	{
+		auto previous = (history.size() > 1) ? history[history.size() - 2] : board{};
+		if (!PlaySan(san, brd, color, previous, move)) return false;
+		visit(brd, color, history, move);
+		brd = move.brd;
+		color = -color;
+		history.push_back(brd);
+	}
+	return true;
+}
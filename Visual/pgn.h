@@ -0,0 +1,66 @@
+/*
+    This header file contains the pgn reading, games and their moves read straight
+    from the text of a (memory mapped) pgn file, and san moves played on engine boards.
+*/
+
+#ifndef _PGN_H
+#define _PGN_H
+
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "engine.h"
+
+//result of a game from whites point of view
+namespace pgn_result {
+  const int black_won = -1;
+  const int draw      = 0;
+  const int white_won = 1;
+  const int unknown   = 2;
+}
+
+//a game of a pgn text, the fen tag (empty for the standard start) and movetext are views into the text
+struct pgn_game
+{
+	std::string_view fen;
+	std::string_view movetext;
+	int result;
+};
+
+//start of the first game at or after a position of a pgn text, a tag line after an empty line (or the text start),
+//last if there is none
+const char* NextGameStart(const char* position, const char* first, const char* last);
+
+//split a pgn text into ranges of about a size that start at games, for reading on several threads
+std::vector<std::pair<const char*, const char*>> SplitGames(const char* first, const char* last, std::size_t size);
+
+//read the next game of a pgn text from position, which is moved past it, false at the end of the text
+bool NextGame(const char*& position, const char* last, pgn_game& game);
+
+//take the next san move off the front of a movetext, skipping move numbers, comments, variations and annotations,
+//false when no moves are left
+bool NextSan(std::string_view& movetext, std::string_view& san);
+
+//a move played from a san move, castling is the king taking its own rook as in polyglot books,
+//promotion is the uppercase piece promoted to or ' '
+struct san_move
+{
+	board brd;
+	int from;
+	int to;
+	char promotion;
+};
+
+//play a san move on a board for the color to move, previous is the board before (empty if unknown) for en passant,
+//castling and en passant are played though the engine itself plays neither, false if it is not a move of the board
+bool PlaySan(std::string_view san, const board& brd, int color, const board& previous, san_move& move);
+
+//a board of a game with the color to move, the boards played up to and including it and the move played from it
+typedef std::function<void(const board& brd, int color, const boards& history, const san_move& move)> game_visitor;
+
+//play a game from its start, or its fen, up to a ply limit visiting each move, false if it is cut short at a move
+//that is not legal
+bool PlayGame(const pgn_game& game, int plies, const game_visitor& visit);
+
+#endif
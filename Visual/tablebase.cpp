@@ -0,0 +1,1170 @@
+/*
+    This code file contains the endgame tablebase probing declared in tablebase.h,
+    decoding the syzygy file format: squares numbered from a1, pieces grouped and indexed
+    by their combinations, the index looked up in huffman coded recursively paired blocks,
+    and the plain position indexed generated tables.
+*/
+
+#include "tablebase.h"
+#include "engineInternal.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+//most pieces on a board any syzygy table covers
+const int tb_pieces = 7;
+
+//file magic of each table type
+const unsigned char wdl_magic[] = { 0x71, 0xE8, 0x23, 0x5D };
+const unsigned char dtz_magic[] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+//flags of a table (a side and leading pawn file)
+namespace tb_flag {
+  const int side_to_move = 1;
+  const int mapped       = 2;
+  const int win_plies    = 4;
+  const int loss_plies   = 8;
+  const int wide         = 16;
+  const int single_value = 128;
+}
+
+//outcome of a table probe
+namespace probe_state {
+  const int fail        = 0;
+  const int ok          = 1;
+  const int change_side = 2;
+  const int zeroing     = 3;
+}
+
+//syzygy piece codes, white pawn to king 1 to 6 and black 9 to 14
+constexpr auto MakeTablebaseCodes()
+{
+	auto codes = std::array<int, 128>{};
+	auto pieces = std::string_view("PNBRQK");
+	for (auto index = 0; index < 6; ++index)
+	{
+		codes[static_cast<unsigned char>(pieces[index])] = index + 1;
+		codes[static_cast<unsigned char>(pieces[index]) + ('a' - 'A')] = index + 9;
+	}
+	return codes;
+}
+constexpr auto tb_code = MakeTablebaseCodes();
+
+//syzygy square of a board index, a1 is 0 while row 0 of the board is rank 8
+constexpr int TablebaseSquare(int index)
+{
+	return index ^ 56;
+}
+
+//rank and file distance of a square from the a1-h8 diagonal, positive above
+constexpr int OffDiagonal(int square)
+{
+	return (square >> 3) - (square & 7);
+}
+
+//tables mapping squares and square combinations to the index of a group of pieces
+struct index_maps
+{
+	std::array<std::array<std::uint64_t, 64>, 6> binomial;
+	std::array<int, 64> pawns;
+	std::array<std::array<int, 64>, 6> lead_pawn_index;
+	std::array<std::array<int, 4>, 6> lead_pawns_size;
+	std::array<int, 64> b1h1h7;
+	std::array<int, 64> a1d1d4;
+	std::array<std::array<int, 64>, 10> kings;
+};
+
+auto MakeIndexMaps()
+{
+	auto maps = index_maps{};
+
+	//squares below the diagonal to 0..27
+	auto code = 0;
+	for (auto square = 0; square < 64; ++square)
+	{
+		if (OffDiagonal(square) < 0) maps.b1h1h7[square] = code++;
+	}
+
+	//squares of the a1-d1-d4 triangle to 0..9, the ones on the diagonal last
+	auto diagonal = std::vector<int>{};
+	code = 0;
+	for (auto square = 0; square <= 27; ++square)
+	{
+		if ((square & 7) > 3) continue;
+		if (OffDiagonal(square) < 0) maps.a1d1d4[square] = code++;
+		else if (OffDiagonal(square) == 0) diagonal.push_back(square);
+	}
+	for (auto square : diagonal) maps.a1d1d4[square] = code++;
+
+	//the 462 legal placements of two kings with the first in the triangle, and the second not above
+	//the diagonal when the first is on it, both on the diagonal last
+	auto both_on_diagonal = std::vector<std::pair<int, int>>{};
+	code = 0;
+	for (auto index = 0; index < 10; ++index)
+	{
+		for (auto first = 0; first <= 27; ++first)
+		{
+			if ((first & 7) > 3 || maps.a1d1d4[first] != index || (index == 0 && first != 1)) continue;
+			for (auto second = 0; second < 64; ++second)
+			{
+				if (std::abs((first >> 3) - (second >> 3)) <= 1 && std::abs((first & 7) - (second & 7)) <= 1) continue;
+				if (OffDiagonal(first) == 0 && OffDiagonal(second) > 0) continue;
+				if (OffDiagonal(first) == 0 && OffDiagonal(second) == 0) both_on_diagonal.emplace_back(index, second);
+				else maps.kings[index][second] = code++;
+			}
+		}
+	}
+	for (auto& kings : both_on_diagonal) maps.kings[kings.first][kings.second] = code++;
+
+	//ways to choose k of n squares
+	maps.binomial[0][0] = 1;
+	for (auto n = 1; n < 64; ++n)
+	{
+		for (auto k = 0; k < 6 && k <= n; ++k)
+		{
+			maps.binomial[k][n] = (k > 0 ? maps.binomial[k - 1][n - 1] : 0) + (k < n ? maps.binomial[k][n - 1] : 0);
+		}
+	}
+
+	//pawn squares a2-h7 to 47..0, the highest is the leading pawn, nearest the edge and then lowest,
+	//and the indexes of the leading pawns per leading pawn file
+	auto available = 47;
+	for (auto count = 1; count <= 5; ++count)
+	{
+		for (auto file = 0; file < 4; ++file)
+		{
+			auto index = 0;
+			for (auto rank = 1; rank <= 6; ++rank)
+			{
+				auto square = rank * 8 + file;
+				if (count == 1)
+				{
+					maps.pawns[square] = available--;
+					maps.pawns[square ^ 7] = available--;
+				}
+				maps.lead_pawn_index[count][square] = index;
+				index += static_cast<int>(maps.binomial[count - 1][maps.pawns[square]]);
+			}
+			maps.lead_pawns_size[count][file] = index;
+		}
+	}
+	return maps;
+}
+const auto tb_maps = MakeIndexMaps();
+
+//little and big endian numbers in the files
+auto ReadLittle16(const unsigned char* data)
+{
+	return static_cast<int>(data[0] | (data[1] << 8));
+}
+
+auto ReadLittle32(const unsigned char* data)
+{
+	return std::uint32_t(data[0]) | (std::uint32_t(data[1]) << 8) | (std::uint32_t(data[2]) << 16) | (std::uint32_t(data[3]) << 24);
+}
+
+auto ReadBig32(const unsigned char* data)
+{
+	return (std::uint32_t(data[0]) << 24) | (std::uint32_t(data[1]) << 16) | (std::uint32_t(data[2]) << 8) | std::uint32_t(data[3]);
+}
+
+//compressed values of one side to move and leading pawn file of a table
+struct pairs_data
+{
+	int flags;
+	std::size_t block_size;
+	std::size_t span;
+	std::size_t blocks;
+	std::size_t block_lengths;
+	std::size_t sparse_entries;
+	int max_symbol_length;
+	int min_symbol_length;
+	const unsigned char* lowest_symbols;
+	std::vector<std::uint64_t> base64;
+	std::vector<std::uint8_t> symbol_lengths;
+	const unsigned char* pairs;
+	const unsigned char* sparse_index;
+	const unsigned char* block_length;
+	const unsigned char* data;
+	std::array<int, tb_pieces> pieces;
+	std::array<int, tb_pieces + 1> group_length;
+	std::array<std::uint64_t, tb_pieces + 1> group_index;
+	std::array<int, 4> map_index;
+};
+
+//a mapped table file, decoded on first probe
+struct tb_table
+{
+	mapped_file file;
+	std::once_flag decoded;
+	bool ready = false;
+	std::array<std::array<pairs_data, 4>, 2> items;
+	const unsigned char* map = nullptr;
+};
+
+//the tables of one material, key is the material with the stronger side white, key2 with it black
+struct tb_entry
+{
+	std::uint64_t key;
+	std::uint64_t key2;
+	int piece_count;
+	bool has_pawns;
+	bool has_unique_pieces;
+	std::array<int, 2> pawn_count;
+	tb_table wdl;
+	tb_table dtz;
+};
+
+auto tb_entries = std::vector<std::unique_ptr<tb_entry>>{};
+auto tb_materials = std::unordered_map<std::uint64_t, tb_entry*>{};
+auto tb_max_pieces = 0;
+
+//material of a board, four bits counting each piece code
+auto MaterialKey(const board& brd)
+{
+	auto key = std::uint64_t{ 0 };
+	for (auto piece : brd)
+	{
+		if (piece != ' ') key += std::uint64_t{ 1 } << (4 * tb_code[static_cast<unsigned char>(piece)]);
+	}
+	return key;
+}
+
+//symbol (pair) of the left or right half of a pair
+auto PairSymbol(const unsigned char* pair, bool right)
+{
+	return right ? (pair[2] << 4) | (pair[1] >> 4) : ((pair[1] & 0xF) << 8) | pair[0];
+}
+
+//number of values a symbol expands into, less one
+int SymbolLength(pairs_data& data, int symbol, std::vector<bool>& visited)
+{
+	visited[symbol] = true;
+	auto pair = data.pairs + 3 * symbol;
+	auto right = PairSymbol(pair, true);
+	if (right == 0xFFF) return 0;
+	auto left = PairSymbol(pair, false);
+	if (!visited[left]) data.symbol_lengths[left] = static_cast<std::uint8_t>(SymbolLength(data, left, visited));
+	if (!visited[right]) data.symbol_lengths[right] = static_cast<std::uint8_t>(SymbolLength(data, right, visited));
+	return data.symbol_lengths[left] + data.symbol_lengths[right] + 1;
+}
+
+//pieces of a table split into groups indexed together, the groups ordered as stored
+auto SetGroups(const tb_entry& entry, pairs_data& data, const int* order, int file)
+{
+	auto groups = 0;
+	auto first_length = entry.has_pawns ? 0 : entry.has_unique_pieces ? 3 : 2;
+	data.group_length[0] = 1;
+	for (auto index = 1; index < entry.piece_count; ++index)
+	{
+		if (--first_length > 0 || data.pieces[index] == data.pieces[index - 1]) data.group_length[groups]++;
+		else data.group_length[++groups] = 1;
+	}
+	data.group_length[++groups] = 0;
+
+	//the first group is at order[0], the remaining pawns at order[1], the other groups follow in turn
+	auto both_pawns = entry.has_pawns && entry.pawn_count[1] != 0;
+	auto next = both_pawns ? 2 : 1;
+	auto free_squares = 64 - data.group_length[0] - (both_pawns ? data.group_length[1] : 0);
+	auto index = std::uint64_t{ 1 };
+	for (auto k = 0; next < groups || k == order[0] || k == order[1]; ++k)
+	{
+		if (k == order[0])
+		{
+			data.group_index[0] = index;
+			index *= entry.has_pawns ? tb_maps.lead_pawns_size[data.group_length[0]][file] : entry.has_unique_pieces ? 31332 : 462;
+		}
+		else if (k == order[1])
+		{
+			data.group_index[1] = index;
+			index *= tb_maps.binomial[data.group_length[1]][48 - data.group_length[0]];
+		}
+		else
+		{
+			data.group_index[next] = index;
+			index *= tb_maps.binomial[data.group_length[next]][free_squares];
+			free_squares -= data.group_length[next++];
+		}
+	}
+	data.group_index[groups] = index;
+}
+
+//huffman code and pairs of a table, the canonical code has longer symbols numbered lower
+auto SetSizes(pairs_data& data, const unsigned char* read)
+{
+	data.flags = *read++;
+	if (data.flags & tb_flag::single_value)
+	{
+		data.blocks = data.block_lengths = data.span = data.sparse_entries = 0;
+		data.min_symbol_length = *read++;
+		return read;
+	}
+	auto groups = std::find(begin(data.group_length), end(data.group_length), 0) - begin(data.group_length);
+	auto size = data.group_index[groups];
+	data.block_size = std::size_t{ 1 } << *read++;
+	data.span = std::size_t{ 1 } << *read++;
+	data.sparse_entries = static_cast<std::size_t>((size + data.span - 1) / data.span);
+	auto padding = *read++;
+	data.blocks = ReadLittle32(read);
+	read += 4;
+	data.block_lengths = data.blocks + padding;
+	data.max_symbol_length = *read++;
+	data.min_symbol_length = *read++;
+	data.lowest_symbols = read;
+
+	//lowest code of each length left aligned in 64 bits, so the length of a code is found by comparing
+	auto lengths = static_cast<std::size_t>(data.max_symbol_length - data.min_symbol_length + 1);
+	data.base64.assign(lengths, 0);
+	for (auto index = static_cast<int>(lengths) - 2; index >= 0; --index)
+	{
+		data.base64[index] = (data.base64[index + 1] + ReadLittle16(data.lowest_symbols + 2 * index)
+			- ReadLittle16(data.lowest_symbols + 2 * (index + 1))) / 2;
+	}
+	for (auto index = std::size_t{ 0 }; index < lengths; ++index)
+	{
+		data.base64[index] <<= 64 - index - data.min_symbol_length;
+	}
+	read += lengths * 2;
+
+	//symbols stand for pairs of symbols, each expanding into the values of both
+	auto symbols = ReadLittle16(read);
+	read += 2;
+	data.pairs = read;
+	data.symbol_lengths.assign(symbols, 0);
+	auto visited = std::vector<bool>(symbols);
+	for (auto symbol = 0; symbol < symbols; ++symbol)
+	{
+		if (!visited[symbol]) data.symbol_lengths[symbol] = static_cast<std::uint8_t>(SymbolLength(data, symbol, visited));
+	}
+	return read + symbols * 3 + (symbols & 1);
+}
+
+//distance to zeroing value tb_maps of each result, when the table stores them mapped
+auto SetDtzMap(tb_table& table, const unsigned char* read, int files)
+{
+	table.map = read;
+	for (auto file = 0; file < files; ++file)
+	{
+		auto& data = table.items[0][file];
+		if (!(data.flags & tb_flag::mapped)) continue;
+		if (data.flags & tb_flag::wide)
+		{
+			read += reinterpret_cast<std::uintptr_t>(read) & 1;
+			for (auto index = 0; index < 4; ++index)
+			{
+				data.map_index[index] = static_cast<int>((read - table.map) / 2 + 1);
+				read += 2 * ReadLittle16(read) + 2;
+			}
+		}
+		else
+		{
+			for (auto index = 0; index < 4; ++index)
+			{
+				data.map_index[index] = static_cast<int>(read - table.map + 1);
+				read += *read + 1;
+			}
+		}
+	}
+	return read + (reinterpret_cast<std::uintptr_t>(read) & 1);
+}
+
+//decode the layout of a mapped table, false if it does not fit the file
+auto DecodeTable(const tb_entry& entry, tb_table& table, bool dtz)
+{
+	auto read = table.file.data() + 4;
+	if (bool(*read & 2) != entry.has_pawns) return false;
+	++read;
+	auto sides = !dtz && entry.key != entry.key2 ? 2 : 1;
+	auto files = entry.has_pawns ? 4 : 1;
+	auto both_pawns = entry.has_pawns && entry.pawn_count[1] != 0;
+	for (auto file = 0; file < files; ++file)
+	{
+		int order[2][2] = { { *read & 0xF, both_pawns ? read[1] & 0xF : 0xF }, { *read >> 4, both_pawns ? read[1] >> 4 : 0xF } };
+		read += 1 + both_pawns;
+		for (auto index = 0; index < entry.piece_count; ++index, ++read)
+		{
+			for (auto side = 0; side < sides; ++side) table.items[side][file].pieces[index] = side ? *read >> 4 : *read & 0xF;
+		}
+		for (auto side = 0; side < sides; ++side) SetGroups(entry, table.items[side][file], order[side], file);
+	}
+	read += reinterpret_cast<std::uintptr_t>(read) & 1;
+	for (auto file = 0; file < files; ++file)
+	{
+		for (auto side = 0; side < sides; ++side) read = SetSizes(table.items[side][file], read);
+	}
+	if (dtz) read = SetDtzMap(table, read, files);
+	for (auto file = 0; file < files; ++file)
+	{
+		for (auto side = 0; side < sides; ++side)
+		{
+			table.items[side][file].sparse_index = read;
+			read += table.items[side][file].sparse_entries * 6;
+		}
+	}
+	for (auto file = 0; file < files; ++file)
+	{
+		for (auto side = 0; side < sides; ++side)
+		{
+			table.items[side][file].block_length = read;
+			read += table.items[side][file].block_lengths * 2;
+		}
+	}
+	for (auto file = 0; file < files; ++file)
+	{
+		for (auto side = 0; side < sides; ++side)
+		{
+			//blocks are aligned to 64 bytes
+			auto& data = table.items[side][file];
+			if (data.blocks) read = reinterpret_cast<const unsigned char*>((reinterpret_cast<std::uintptr_t>(read) + 0x3F) & ~std::uintptr_t{ 0x3F });
+			data.data = read;
+			read += data.blocks * data.block_size;
+		}
+	}
+	return read <= table.file.data() + table.file.size();
+}
+
+//value at an index of a table, from the block holding it
+auto DecompressPairs(const pairs_data& data, std::uint64_t index)
+{
+	if (data.flags & tb_flag::single_value) return data.min_symbol_length;
+
+	//the sparse index points at the block and offset of every span-th value, from the middle of the span
+	//walk the block lengths to the block of the index
+	auto sparse = data.sparse_index + 6 * (index / data.span);
+	auto block = ReadLittle32(sparse);
+	auto offset = ReadLittle16(sparse + 4);
+	offset += static_cast<int>(index % data.span) - static_cast<int>(data.span / 2);
+	while (offset < 0) offset += ReadLittle16(data.block_length + 2 * --block) + 1;
+	while (offset > ReadLittle16(data.block_length + 2 * block)) offset -= ReadLittle16(data.block_length + 2 * block++) + 1;
+
+	//read the codes of the block until the symbol holding the offset
+	auto read = data.data + std::uint64_t{ block } * data.block_size;
+	auto buffer = (std::uint64_t{ ReadBig32(read) } << 32) | ReadBig32(read + 4);
+	read += 8;
+	auto buffer_size = 64;
+	auto symbol = 0;
+	while (true)
+	{
+		auto length = 0;
+		while (buffer < data.base64[length]) ++length;
+		symbol = static_cast<int>((buffer - data.base64[length]) >> (64 - length - data.min_symbol_length));
+		symbol += ReadLittle16(data.lowest_symbols + 2 * length);
+		if (offset < data.symbol_lengths[symbol] + 1) break;
+		offset -= data.symbol_lengths[symbol] + 1;
+		length += data.min_symbol_length;
+		buffer <<= length;
+		buffer_size -= length;
+		if (buffer_size <= 32)
+		{
+			buffer_size += 32;
+			buffer |= std::uint64_t{ ReadBig32(read) } << (64 - buffer_size);
+			read += 4;
+		}
+	}
+
+	//expand the pairs of the symbol down to the single value at the offset
+	while (data.symbol_lengths[symbol])
+	{
+		auto pair = data.pairs + 3 * symbol;
+		auto left = PairSymbol(pair, false);
+		if (offset < data.symbol_lengths[left] + 1) symbol = left;
+		else
+		{
+			offset -= data.symbol_lengths[left] + 1;
+			symbol = PairSymbol(pair, true);
+		}
+	}
+	return PairSymbol(data.pairs + 3 * symbol, false);
+}
+
+//leading pawn order, the one nearest the edge and then lowest leads
+auto PawnBefore(int square1, int square2)
+{
+	return tb_maps.pawns[square1] < tb_maps.pawns[square2];
+}
+
+//probe a decoded table for a board, for distance to zeroing the board result is needed to map the value
+int ProbeTable(const tb_entry& entry, bool dtz, const board& brd, int color, int result, int& state)
+{
+	auto& table = dtz ? entry.dtz : entry.wdl;
+
+	//the tables have the stronger side white, and only white to move when both sides are the same,
+	//else the colors are swapped and the board flipped
+	auto flip = (entry.key == entry.key2 && color == black) || MaterialKey(brd) != entry.key;
+	auto flip_color = flip ? 8 : 0;
+	auto flip_squares = flip ? 56 : 0;
+	auto side = int(flip) ^ int(color == black);
+
+	//with pawns a table is split by the file of the leading pawn, mirrored to files a-d
+	auto squares = std::array<int, tb_pieces>{};
+	auto pieces = std::array<int, tb_pieces>{};
+	auto size = 0;
+	auto lead_pawns = 0;
+	auto lead_pawn = 0;
+	auto file = 0;
+	if (entry.has_pawns)
+	{
+		lead_pawn = table.items[0][0].pieces[0] ^ flip_color;
+		for (auto square = 0; square < 64; ++square)
+		{
+			if (tb_code[static_cast<unsigned char>(brd[TablebaseSquare(square)])] == lead_pawn) squares[size++] = square ^ flip_squares;
+		}
+		lead_pawns = size;
+		std::swap(squares[0], *std::max_element(begin(squares), begin(squares) + lead_pawns, PawnBefore));
+		file = squares[0] & 7;
+		if (file > 3) file = (squares[0] ^ 7) & 7;
+	}
+
+	//distance to zeroing tables are stored for one side to move only
+	auto& data = table.items[dtz ? 0 : side][file];
+	if (dtz && (data.flags & tb_flag::side_to_move) != side && !(entry.key == entry.key2 && !entry.has_pawns))
+	{
+		state = probe_state::change_side;
+		return 0;
+	}
+
+	//the other pieces, in the order of the table
+	for (auto square = 0; square < 64; ++square)
+	{
+		auto code = tb_code[static_cast<unsigned char>(brd[TablebaseSquare(square)])];
+		if (code == 0 || (entry.has_pawns && code == lead_pawn)) continue;
+		squares[size] = square ^ flip_squares;
+		pieces[size++] = code ^ flip_color;
+	}
+	for (auto index = lead_pawns; index < size - 1; ++index)
+	{
+		for (auto other = index + 1; other < size; ++other)
+		{
+			if (data.pieces[index] != pieces[other]) continue;
+			std::swap(pieces[index], pieces[other]);
+			std::swap(squares[index], squares[other]);
+			break;
+		}
+	}
+
+	//mirror the leading piece to the a1-d1-d4 triangle
+	if ((squares[0] & 7) > 3)
+	{
+		for (auto index = 0; index < size; ++index) squares[index] ^= 7;
+	}
+	auto index = std::uint64_t{ 0 };
+	if (entry.has_pawns)
+	{
+		index = tb_maps.lead_pawn_index[lead_pawns][squares[0]];
+		std::stable_sort(begin(squares) + 1, begin(squares) + lead_pawns, PawnBefore);
+		for (auto pawn = 1; pawn < lead_pawns; ++pawn) index += tb_maps.binomial[pawn][tb_maps.pawns[squares[pawn]]];
+	}
+	else
+	{
+		if ((squares[0] >> 3) > 3)
+		{
+			for (auto piece = 0; piece < size; ++piece) squares[piece] ^= 56;
+		}
+		//the first piece of the leading group off the diagonal goes below it
+		for (auto piece = 0; piece < data.group_length[0]; ++piece)
+		{
+			if (!OffDiagonal(squares[piece])) continue;
+			if (OffDiagonal(squares[piece]) > 0)
+			{
+				for (auto other = piece; other < size; ++other) squares[other] = ((squares[other] >> 3) | (squares[other] << 3)) & 63;
+			}
+			break;
+		}
+		if (entry.has_unique_pieces)
+		{
+			//three unique pieces (kings included) indexed together, by how many are on the diagonal
+			auto adjust1 = int(squares[1] > squares[0]);
+			auto adjust2 = int(squares[2] > squares[0]) + int(squares[2] > squares[1]);
+			if (OffDiagonal(squares[0]))
+			{
+				index = (tb_maps.a1d1d4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+			}
+			else if (OffDiagonal(squares[1]))
+			{
+				index = (6 * 63 + (squares[0] >> 3) * 28 + tb_maps.b1h1h7[squares[1]]) * 62 + squares[2] - adjust2;
+			}
+			else if (OffDiagonal(squares[2]))
+			{
+				index = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] >> 3) * 7 * 28 + ((squares[1] >> 3) - adjust1) * 28
+					+ tb_maps.b1h1h7[squares[2]];
+			}
+			else
+			{
+				index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] >> 3) * 7 * 6 + ((squares[1] >> 3) - adjust1) * 6
+					+ ((squares[2] >> 3) - adjust2);
+			}
+		}
+		else
+		{
+			//the two kings indexed together
+			index = tb_maps.kings[tb_maps.a1d1d4[squares[0]]][squares[1]];
+		}
+	}
+
+	//the remaining groups as combinations of the squares the groups before leave free
+	index *= data.group_index[0];
+	auto group = begin(squares) + data.group_length[0];
+	auto remaining_pawns = entry.has_pawns && entry.pawn_count[1] != 0;
+	for (auto next = 1; data.group_length[next]; ++next)
+	{
+		std::stable_sort(group, group + data.group_length[next]);
+		auto combination = std::uint64_t{ 0 };
+		for (auto piece = 0; piece < data.group_length[next]; ++piece)
+		{
+			auto before = std::count_if(begin(squares), group, [&](int square) { return group[piece] > square; });
+			combination += tb_maps.binomial[piece + 1][group[piece] - before - 8 * remaining_pawns];
+		}
+		remaining_pawns = false;
+		index += combination * data.group_index[next];
+		group += data.group_length[next];
+	}
+
+	state = probe_state::ok;
+	auto value = DecompressPairs(data, index);
+	if (!dtz) return value - 2;
+
+	//distance to zeroing values may be mapped per result and stored in moves rather than plies
+	if (data.flags & tb_flag::mapped)
+	{
+		const int map_of[] = { 1, 3, 0, 2, 0 };
+		auto map_index = data.map_index[map_of[result + 2]] + value;
+		value = (data.flags & tb_flag::wide) ? ReadLittle16(table.map + 2 * map_index) : table.map[map_index];
+	}
+	if ((result == wdl::win && !(data.flags & tb_flag::win_plies)) || (result == wdl::loss && !(data.flags & tb_flag::loss_plies))
+		|| result == wdl::cursed_win || result == wdl::blessed_loss)
+	{
+		value *= 2;
+	}
+	return value + 1;
+}
+
+//entry of the material of a board with its table decoded, null if it is not mapped
+auto FindTable(const board& brd, bool dtz)
+{
+	auto found = tb_materials.find(MaterialKey(brd));
+	if (found == end(tb_materials)) return static_cast<tb_entry*>(nullptr);
+	auto& entry = *found->second;
+	auto& table = dtz ? entry.dtz : entry.wdl;
+	if (table.file.empty()) return static_cast<tb_entry*>(nullptr);
+	std::call_once(table.decoded, [&]() { table.ready = DecodeTable(entry, table, dtz); });
+	return table.ready ? &entry : nullptr;
+}
+
+//the a1-d1-d4 triangle of board indexes, a code of each square in it and -1 off it
+constexpr auto MakeTriangleCodes()
+{
+	auto codes = std::array<int, 64>{};
+	auto code = 0;
+	for (auto index = 0; index < 64; ++index)
+	{
+		auto rank = 7 - index / 8;
+		auto file = index % 8;
+		codes[index] = (rank <= file && file <= 3) ? code++ : -1;
+	}
+	return codes;
+}
+constexpr auto triangle_code = MakeTriangleCodes();
+
+constexpr auto MakeTriangleSquares()
+{
+	auto squares = std::array<int, 10>{};
+	for (auto index = 0; index < 64; ++index)
+	{
+		if (triangle_code[index] >= 0) squares[triangle_code[index]] = index;
+	}
+	return squares;
+}
+constexpr auto triangle_square = MakeTriangleSquares();
+
+//rank and file distance of a board index from the a1-h8 diagonal, positive above
+constexpr int BoardOffDiagonal(int index)
+{
+	return (7 - index / 8) - index % 8;
+}
+
+//layout of the generated table of a material name
+generated_layout GeneratedLayout(const std::string& name)
+{
+	auto layout = generated_layout{ name, std::string{}, name.find('P') != std::string::npos, 0 };
+	auto black_side = false;
+	for (auto piece : name)
+	{
+		if (piece == 'v') black_side = true;
+		else layout.pieces += black_side ? char(std::tolower(piece)) : piece;
+	}
+	layout.size = layout.has_pawns ? 32 : 10;
+	for (auto index = std::size_t{ 1 }; index < layout.pieces.size(); ++index)
+	{
+		layout.size *= std::toupper(layout.pieces[index]) == 'P' ? 48 : 64;
+	}
+	return layout;
+}
+
+//index of a position from the board indexes of its pieces in name order
+std::uint64_t GeneratedIndex(const generated_layout& layout, std::array<int, 7> squares)
+{
+	auto count = layout.pieces.size();
+	if (squares[0] % 8 > 3)
+	{
+		for (auto index = std::size_t{ 0 }; index < count; ++index) squares[index] ^= 7;
+	}
+	if (!layout.has_pawns)
+	{
+		if (squares[0] < 32)
+		{
+			for (auto index = std::size_t{ 0 }; index < count; ++index) squares[index] ^= 56;
+		}
+		for (auto index = std::size_t{ 0 }; index < count; ++index)
+		{
+			if (!BoardOffDiagonal(squares[index])) continue;
+			if (BoardOffDiagonal(squares[index]) > 0)
+			{
+				for (auto& square : squares) square = (7 - square % 8) * 8 + (7 - square / 8);
+			}
+			break;
+		}
+	}
+	auto position = std::uint64_t(layout.has_pawns ? squares[0] / 8 * 4 + squares[0] % 8 : triangle_code[squares[0]]);
+	for (auto index = std::size_t{ 1 }; index < count; ++index)
+	{
+		if (std::toupper(layout.pieces[index]) != 'P') position = position * 64 + squares[index];
+		else if (squares[index] < 8 || squares[index] >= 56) return layout.size;
+		else position = position * 48 + squares[index] - 8;
+	}
+	return position;
+}
+
+//board indexes of the pieces of a position index, in name order
+void GeneratedSquares(const generated_layout& layout, std::uint64_t index, std::array<int, 7>& squares)
+{
+	for (auto piece = static_cast<int>(layout.pieces.size()) - 1; piece > 0; --piece)
+	{
+		auto pawn = std::toupper(layout.pieces[piece]) == 'P';
+		auto base = pawn ? 48 : 64;
+		squares[piece] = static_cast<int>(index % base) + (pawn ? 8 : 0);
+		index /= base;
+	}
+	squares[0] = layout.has_pawns ? static_cast<int>(index / 4 * 8 + index % 4) : triangle_square[index];
+}
+
+//a mapped generated table
+struct generated_entry
+{
+	generated_layout layout;
+	mapped_file wdl;
+	mapped_file dtm;
+};
+
+auto tb_generated = std::unordered_map<std::uint64_t, std::unique_ptr<generated_entry>>{};
+
+//material with the colors swapped, the black piece codes are the white ones plus 8
+auto SwapColors(std::uint64_t key)
+{
+	return ((key >> 32) & 0x0FFFFFF0) | ((key & 0x0FFFFFF0) << 32);
+}
+
+//generated table of a board and the position in it, null if none covers it
+auto FindGenerated(const board& brd, int color, std::uint64_t& position)
+{
+	auto key = MaterialKey(brd);
+	auto found = tb_generated.find(key);
+	auto swapped = found == end(tb_generated);
+	if (swapped) found = tb_generated.find(SwapColors(key));
+	if (found == end(tb_generated)) return static_cast<generated_entry*>(nullptr);
+
+	//the stronger side is white in the table, else the colors are swapped and the board flipped
+	auto& layout = found->second->layout;
+	auto squares = std::array<int, 7>{};
+	auto at = std::size_t{ 0 };
+	for (auto index = std::size_t{ 0 }; index < layout.pieces.size(); ++index)
+	{
+		auto piece = layout.pieces[index];
+		if (swapped) piece = std::isupper(piece) ? char(std::tolower(piece)) : char(std::toupper(piece));
+		at = brd.find(piece, (index > 0 && layout.pieces[index] == layout.pieces[index - 1]) ? at + 1 : 0);
+		squares[index] = static_cast<int>(at) ^ (swapped ? 56 : 0);
+	}
+	position = GeneratedIndex(layout, squares);
+	if (position >= layout.size) return static_cast<generated_entry*>(nullptr);
+	if ((color == black) != swapped) position += layout.size;
+	return found->second.get();
+}
+
+//result of a generated table position, one of generated::loss to generated::broken
+auto GeneratedValue(const generated_entry& entry, std::uint64_t position)
+{
+	return (entry.wdl.data()[generated::magic_size + position / 4] >> (2 * (position % 4))) & 3;
+}
+
+//win/draw/loss of a board from the generated tables, false if none covers it
+auto GeneratedResult(const board& brd, int color, int& result)
+{
+	auto position = std::uint64_t{ 0 };
+	auto entry = FindGenerated(brd, color, position);
+	if (!entry) return false;
+	auto value = GeneratedValue(*entry, position);
+	if (value == generated::broken) return false;
+	result = value == generated::win ? wdl::win : value == generated::loss ? wdl::loss : wdl::draw;
+	return true;
+}
+
+//win/draw/loss straight from the table, or the generated table when there is no syzygy table
+auto ProbeWDLTable(const board& brd, int color, int& state)
+{
+	if (std::count(begin(brd), end(brd), ' ') == 62) return wdl::draw;
+	auto entry = FindTable(brd, false);
+	if (!entry)
+	{
+		auto result = wdl::draw;
+		state = GeneratedResult(brd, color, result) ? probe_state::ok : probe_state::fail;
+		return result;
+	}
+	return ProbeTable(*entry, false, brd, color, 0, state);
+}
+
+//moves of the boards a probe searches, a list per depth of the probe kept by the thread, and the board it starts from,
+//so probing from the search does not allocate once they have grown, a deque keeps the lists in place as it grows
+thread_local auto probe_lists = std::deque<move_list>{};
+thread_local auto probe_root = score_board{};
+
+//moves of a board into the list of its probe depth, the material, phase and keys of the boards are not used
+auto& ProbeMoves(const score_board& sbrd, int color, std::size_t depth)
+{
+	if (probe_lists.size() <= depth) probe_lists.resize(depth + 1);
+	auto& yield = probe_lists[depth];
+	GenerateMoves(yield, sbrd, color);
+	return yield;
+}
+
+auto& ProbeRoot(const board& brd)
+{
+	probe_root.brd.assign(brd);
+	return probe_root;
+}
+
+//the tables store don't care values where a capture (or a pawn move, for distance to zeroing) is best,
+//so the captures are searched and the best of them and the table value is the result
+int SearchWDL(const score_board& sbrd, int color, bool pawn_moves, int& state, std::size_t depth)
+{
+	auto& brd = sbrd.brd;
+	auto best = wdl::loss;
+	auto& next_boards = ProbeMoves(sbrd, color, depth);
+	auto searched = std::size_t{ 0 };
+	for (auto& next : next_boards)
+	{
+		if (next.captured == ' ' && (!pawn_moves || std::toupper(brd[next.from]) != 'P')) continue;
+		++searched;
+		auto value = -SearchWDL(next, -color, false, state, depth + 1);
+		if (state == probe_state::fail) return wdl::draw;
+		if (value > best)
+		{
+			best = value;
+			if (value >= wdl::win)
+			{
+				state = probe_state::zeroing;
+				return value;
+			}
+		}
+	}
+	//with every move searched the table value is not needed, and may be wrong
+	auto all_searched = searched != 0 && searched == next_boards.size;
+	auto value = best;
+	if (!all_searched)
+	{
+		value = ProbeWDLTable(brd, color, state);
+		if (state == probe_state::fail) return wdl::draw;
+	}
+	if (best >= value)
+	{
+		state = (best > wdl::draw || all_searched) ? probe_state::zeroing : probe_state::ok;
+		return best;
+	}
+	state = probe_state::ok;
+	return value;
+}
+
+//distance to zeroing of a board whose best move zeroes
+auto ZeroingDistance(int result)
+{
+	return result == wdl::win ? 1 : result == wdl::cursed_win ? 101 : result == wdl::blessed_loss ? -101 : result == wdl::loss ? -1 : 0;
+}
+
+auto Sign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+int SearchDTZ(const score_board& sbrd, int color, int& state, std::size_t depth)
+{
+	auto& brd = sbrd.brd;
+	state = probe_state::ok;
+	auto result = SearchWDL(sbrd, color, true, state, depth);
+	if (state == probe_state::fail || result == wdl::draw) return 0;
+	if (state == probe_state::zeroing) return ZeroingDistance(result);
+	auto entry = FindTable(brd, true);
+	if (!entry)
+	{
+		state = probe_state::fail;
+		return 0;
+	}
+	auto distance = ProbeTable(*entry, true, brd, color, result, state);
+	if (state == probe_state::fail) return 0;
+	if (state != probe_state::change_side)
+	{
+		return (distance + 100 * (result == wdl::blessed_loss || result == wdl::cursed_win)) * Sign(result);
+	}
+
+	//the table is stored for the other side to move, so take the best move by the distance after it
+	auto best = 0xFFFF;
+	for (auto& next : ProbeMoves(sbrd, color, depth))
+	{
+		auto zeroing = next.captured != ' ' || std::toupper(brd[next.from]) == 'P';
+		distance = zeroing ? -ZeroingDistance(SearchWDL(next, -color, false, state, depth + 1)) : -SearchDTZ(next, -color, state, depth + 1);
+		if (state == probe_state::fail) return 0;
+		std::size_t king_index = 0;
+		if (distance == 1 && IsInCheck(next.brd, -color, king_index) && ProbeMoves(next, -color, depth + 1).size == 0) best = 1;
+		if (!zeroing) distance += Sign(distance);
+		if (distance < best && Sign(distance) == Sign(result)) best = distance;
+	}
+	//no moves is mate
+	return best == 0xFFFF ? -1 : best;
+}
+
+//the material of a table name like "KRPvKR", the first side white
+auto NameMaterial(const std::string& name, bool swap)
+{
+	auto key = std::uint64_t{ 0 };
+	auto black_side = swap;
+	for (auto piece : name)
+	{
+		if (piece == 'v') black_side = !black_side;
+		else key += std::uint64_t{ 1 } << (4 * (tb_code[static_cast<unsigned char>(piece)] + (black_side ? 8 : 0)));
+	}
+	return key;
+}
+
+//entry of a material from its table name
+auto MakeEntry(const std::string& name)
+{
+	auto entry = std::unique_ptr<tb_entry>(new tb_entry{});
+	entry->key = NameMaterial(name, false);
+	entry->key2 = NameMaterial(name, true);
+	auto separator = name.find('v');
+	auto strong = name.substr(0, separator);
+	auto weak = name.substr(separator + 1);
+	entry->piece_count = static_cast<int>(strong.size() + weak.size());
+	entry->has_pawns = name.find('P') != std::string::npos;
+	for (auto side : { strong, weak })
+	{
+		for (auto piece : std::string("PNBRQ"))
+		{
+			if (std::count(begin(side), end(side), piece) == 1) entry->has_unique_pieces = true;
+		}
+	}
+	//the side with fewer pawns (but some) leads, white when even
+	auto white_pawns = static_cast<int>(std::count(begin(strong), end(strong), 'P'));
+	auto black_pawns = static_cast<int>(std::count(begin(weak), end(weak), 'P'));
+	auto white_leads = black_pawns == 0 || (white_pawns != 0 && black_pawns >= white_pawns);
+	entry->pawn_count = white_leads ? std::array<int, 2>{ white_pawns, black_pawns } : std::array<int, 2>{ black_pawns, white_pawns };
+	return entry;
+}
+
+//map a generated table file of the first directory that has it, empty if none does or it does not fit the layout
+auto MapGenerated(const std::vector<std::string>& directories, const std::string& file_name, const char* magic, std::uint64_t size)
+{
+	for (auto& directory : directories)
+	{
+		auto file = mapped_file(directory + "/" + file_name);
+		if (file.empty()) continue;
+		if (file.size() == generated::magic_size + size && std::memcmp(file.data(), magic, generated::magic_size) == 0) return file;
+	}
+	return mapped_file{};
+}
+
+//map a table file of the first directory that has it, empty if none does or it is not a table
+auto MapTable(const std::vector<std::string>& directories, const std::string& file_name, const unsigned char* magic)
+{
+	for (auto& directory : directories)
+	{
+		auto file = mapped_file(directory + "/" + file_name);
+		if (file.empty()) continue;
+		if (file.size() % 64 == 16 && std::memcmp(file.data(), magic, 4) == 0) return file;
+	}
+	return mapped_file{};
+}
+
+//pieces other than the king of one side, strongest first
+void AddSides(std::vector<std::string>& sides, const std::string& side, std::size_t first, int count)
+{
+	sides.push_back(side);
+	if (count == 0) return;
+	auto pieces = std::string("QRBNP");
+	for (auto index = first; index < pieces.size(); ++index) AddSides(sides, side + pieces[index], index, count - 1);
+}
+
+//map the syzygy and generated tables found in the directories of a path, separated by ':' (';' on windows)
+int SetTablebasePath(const std::string& path)
+{
+	tb_materials.clear();
+	tb_entries.clear();
+	tb_generated.clear();
+	tb_max_pieces = 0;
+#ifdef _WIN32
+	const auto separator = ';';
+#else
+	const auto separator = ':';
+#endif
+	auto directories = std::vector<std::string>{};
+	auto start = std::size_t{ 0 };
+	while (start <= path.size())
+	{
+		auto end = std::min(path.find(separator, start), path.size());
+		if (end > start) directories.push_back(path.substr(start, end - start));
+		start = end + 1;
+	}
+	if (directories.empty()) return 0;
+
+	//every table name up to the most pieces, each material is one file named either way round
+	auto sides = std::vector<std::string>{};
+	AddSides(sides, "K", 0, tb_pieces - 2);
+	for (auto& strong : sides)
+	{
+		for (auto& weak : sides)
+		{
+			if (strong.size() + weak.size() > tb_pieces || (strong.size() == 1 && weak.size() == 1)) continue;
+			auto name = strong + "v" + weak;
+			auto key = NameMaterial(name, false);
+			if (!tb_generated.count(key) && !tb_generated.count(SwapColors(key)))
+			{
+				auto entry = std::unique_ptr<generated_entry>(new generated_entry{ GeneratedLayout(name), mapped_file{}, mapped_file{} });
+				entry->wdl = MapGenerated(directories, name + ".ctbw", generated::wdl_magic, (2 * entry->layout.size + 3) / 4);
+				entry->dtm = MapGenerated(directories, name + ".ctbm", generated::dtm_magic, 2 * entry->layout.size);
+				if (!entry->wdl.empty())
+				{
+					tb_max_pieces = std::max(tb_max_pieces, static_cast<int>(entry->layout.pieces.size()));
+					tb_generated[key] = std::move(entry);
+				}
+			}
+			if (tb_materials.count(key)) continue;
+			auto wdl_file = MapTable(directories, name + ".rtbw", wdl_magic);
+			if (wdl_file.empty()) continue;
+			auto entry = MakeEntry(name);
+			entry->wdl.file = std::move(wdl_file);
+			entry->dtz.file = MapTable(directories, name + ".rtbz", dtz_magic);
+			tb_materials[entry->key] = entry.get();
+			tb_materials[entry->key2] = entry.get();
+			tb_max_pieces = std::max(tb_max_pieces, entry->piece_count);
+			tb_entries.push_back(std::move(entry));
+		}
+	}
+	return tb_max_pieces;
+}
+
+//most pieces on a board the mapped tables cover, zero without tables
+int TablebasePieces()
+{
+	return tb_max_pieces;
+}
+
+//win/draw/loss of a board for the color to move, false if no table covers it
+bool ProbeWDL(const board& brd, int color, int& result)
+{
+	auto state = probe_state::ok;
+	result = SearchWDL(ProbeRoot(brd), color, false, state, 0);
+	return state != probe_state::fail;
+}
+
+//distance to zeroing (a capture or pawn move) in plies, false if no table covers it
+bool ProbeDTZ(const board& brd, int color, int& result)
+{
+	auto state = probe_state::ok;
+	result = SearchDTZ(ProbeRoot(brd), color, state, 0);
+	return state != probe_state::fail;
+}
+
+//win/draw/loss and plies to mate of a board for the color to move from the generated tables
+bool ProbeDTM(const board& brd, int color, int& result, int& plies)
+{
+	result = wdl::draw;
+	plies = 0;
+	if (std::count(begin(brd), end(brd), ' ') == 62) return true;
+	auto position = std::uint64_t{ 0 };
+	auto entry = FindGenerated(brd, color, position);
+	if (!entry || entry->dtm.empty()) return false;
+	auto value = GeneratedValue(*entry, position);
+	if (value == generated::broken) return false;
+	if (value == generated::draw) return true;
+
+	//moves to mate, the winner moves first
+	auto moves = static_cast<int>(entry->dtm.data()[generated::magic_size + position]);
+	result = value == generated::win ? wdl::win : wdl::loss;
+	plies = value == generated::win ? 2 * moves - 1 : 2 * moves;
+	return true;
+}
+
+//largest rank of a root move, for the distances of the wins and losses
+const int max_rank = 1 << 16;
+
+//rank of each root move by its distance to zeroing counted from the root, false if a move is not covered
+auto RankByZeroing(const board& brd, int color, const score_boards& next_boards, std::vector<int>& ranks)
+{
+	for (auto& next : next_boards)
+	{
+		auto state = probe_state::ok;
+		auto distance = 0;
+		if (next.captured != ' ' || std::toupper(brd[next.from]) == 'P')
+		{
+			distance = ZeroingDistance(-SearchWDL(next, -color, false, state, 0));
+		}
+		else
+		{
+			distance = -SearchDTZ(next, -color, state, 0);
+			distance += Sign(distance);
+		}
+		if (state == probe_state::fail) return false;
+		std::size_t king_index = 0;
+		if (distance == 2 && IsInCheck(next.brd, -color, king_index) && ProbeMoves(next, -color, 0).size == 0) distance = 1;
+		ranks.push_back(distance > 0 ? max_rank - distance : distance < 0 ? -max_rank - distance : 0);
+	}
+	return true;
+}
+
+//rank of each root move by its distance to mate counted from the root, false if a move is not covered
+auto RankByMate(const score_boards& next_boards, int color, std::vector<int>& ranks)
+{
+	for (auto& next : next_boards)
+	{
+		auto result = wdl::draw;
+		auto plies = 0;
+		if (!ProbeDTM(next.brd, -color, result, plies)) return false;
+		ranks.push_back(result == wdl::loss ? max_rank - (plies + 1) : result == wdl::win ? -max_rank + (plies + 1) : 0);
+	}
+	return true;
+}
+
+//keep only the root moves that hold the result of a board, the quickest to zeroing (or mate) when winning
+//and the slowest when losing
+bool FilterRootMoves(const board& brd, int color, score_boards& next_boards)
+{
+	if (next_boards.empty()) return false;
+	auto ranks = std::vector<int>{};
+	if (!RankByZeroing(brd, color, next_boards, ranks))
+	{
+		ranks.clear();
+		if (!RankByMate(next_boards, color, ranks)) return false;
+	}
+	auto best = *std::max_element(begin(ranks), end(ranks));
+	auto kept = score_boards{};
+	for (auto index = std::size_t{ 0 }; index < next_boards.size(); ++index)
+	{
+		if (ranks[index] == best) kept.push_back(next_boards[index]);
+	}
+	next_boards.swap(kept);
+	return true;
+}
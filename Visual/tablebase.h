@@ -0,0 +1,82 @@
+/*
+    This header file contains the endgame tablebase probing,
+    exact win/draw/loss and distance to zeroing results for boards with few pieces
+    read from memory mapped syzygy tables, and win/draw/loss and distance to mate
+    from the tables of the generator.
+*/
+
+#ifndef _TABLEBASE_H
+#define _TABLEBASE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "engine.h"
+
+//win/draw/loss of a board for the side to move, cursed wins and blessed losses are wins and losses
+//the fifty move rule turns into draws
+namespace wdl {
+  const int loss         = -2;
+  const int blessed_loss = -1;
+  const int draw         = 0;
+  const int cursed_win   = 1;
+  const int win          = 2;
+}
+
+//generated tables, files of the material name like "KRvKP" with the stronger side white:
+//.ctbw with two bits of result per position, .ctbm with a byte of moves to mate per position (0 for draws),
+//each after its magic, all positions for white to move then all for black to move
+namespace generated {
+  const char wdl_magic[] = "CTGTBW01";
+  const char dtm_magic[] = "CTGTBM01";
+  const int magic_size   = 8;
+  const int loss         = 0;
+  const int draw         = 1;
+  const int win          = 2;
+  const int broken       = 3;
+}
+
+//pieces of a generated table in name order, white then black, and its positions for one side to move
+struct generated_layout
+{
+	std::string name;
+	std::string pieces;
+	bool has_pawns;
+	std::uint64_t size;
+};
+
+//layout of the generated table of a material name
+generated_layout GeneratedLayout(const std::string& name);
+
+//index of a position from the board indexes of its pieces in name order, mirrored so the white king is
+//on files a-d, and without pawns also on ranks 1-4 with the first piece off the a1-h8 diagonal below it,
+//the size of the layout if a pawn is on a last rank
+std::uint64_t GeneratedIndex(const generated_layout& layout, std::array<int, 7> squares);
+
+//board indexes of the pieces of a position index, in name order
+void GeneratedSquares(const generated_layout& layout, std::uint64_t index, std::array<int, 7>& squares);
+
+//map the syzygy tables (.rtbw win/draw/loss, .rtbz distance to zeroing) and the generated tables (.ctbw, .ctbm)
+//found in the directories of a path, separated by ':' (';' on windows),
+//the syzygy tables themselves are read on first probe, not while searching
+int SetTablebasePath(const std::string& path);
+
+//most pieces on a board the mapped tables cover, zero without tables
+int TablebasePieces();
+
+//win/draw/loss of a board for the color to move, false if no table covers it
+bool ProbeWDL(const board& brd, int color, int& result);
+
+//distance to zeroing (a capture or pawn move) in plies, positive when winning and negative when losing,
+//zero for a draw, counted 100 more for cursed wins and blessed losses, false if no table covers it
+bool ProbeDTZ(const board& brd, int color, int& result);
+
+//win/draw/loss and plies to mate of a board for the color to move from the generated tables,
+//plies are zero for a draw, false if no generated table covers it
+bool ProbeDTM(const board& brd, int color, int& result, int& plies);
+
+//keep only the root moves that hold the result of a board, the quickest to zeroing (or mate) when winning
+//and the slowest when losing, false and the moves untouched if no table covers them
+bool FilterRootMoves(const board& brd, int color, score_boards& next_boards);
+
+#endif
@@ -0,0 +1,541 @@
+/*
+    This code file contains the tablebase generator, retrograde analysis of every endgame
+    up to a number of pieces, written as the generated tables the engine probes (see tablebase.h).
+*/
+
+#include "tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+//generator parameters, and the plies of a position that is not a win or loss in some plies
+namespace tbgen {
+  const int default_pieces     = 4;
+  const int max_pieces         = 5;
+  const std::uint64_t chunk    = 1 << 12;
+  const std::uint16_t unknown  = 0xFFFF;
+  const std::uint16_t drawn    = 0xFFFE;
+  const std::uint16_t broken   = 0xFFFD;
+  const std::uint16_t resolved = 0xFFFC;
+}
+
+//moves of the kings (all directions) and knights, as row and file steps
+const int king_steps[8][2] = { { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+const int knight_steps[8][2] = { { -2, -1 }, { -2, 1 }, { -1, -2 }, { -1, 2 }, { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+
+//a position of a table, its board and the board indexes of its pieces in name order
+struct tb_position
+{
+	board brd;
+	std::array<int, 7> squares;
+	int color;
+};
+
+//a table being generated, the plies to mate of each position (odd wins, even losses),
+//the loss scheduled for a later ply and the best move out of the table of each position
+struct table_generator
+{
+	generated_layout layout;
+	std::size_t black_king;
+	std::uint64_t positions;
+	std::unique_ptr<std::atomic<std::uint16_t>[]> plies;
+	std::unique_ptr<std::atomic<std::uint16_t>[]> pending;
+	std::unique_ptr<std::uint16_t[]> exits;
+	std::atomic<int> highest;
+	std::atomic<bool> missing;
+};
+
+auto PieceOf(char piece, int color)
+{
+	return color == white ? piece : char(std::tolower(piece));
+}
+
+auto ColorOf(char piece)
+{
+	return piece == ' ' ? empty : piece > 'Z' ? black : white;
+}
+
+auto OnBoard(int row, int file)
+{
+	return 0 <= row && row < 8 && 0 <= file && file < 8;
+}
+
+//test if a square is attacked by the pieces of a color
+auto Attacked(const board& brd, int square, int by)
+{
+	auto row = square / 8;
+	auto file = square % 8;
+	auto PieceAt = [&](int at_row, int at_file)
+		{
+			return OnBoard(at_row, at_file) ? brd[at_row * 8 + at_file] : '\0';
+		};
+	//white pawns move up the board to row 0, so attack from the row below
+	auto pawn_row = row + (by == white ? 1 : -1);
+	if (PieceAt(pawn_row, file - 1) == PieceOf('P', by) || PieceAt(pawn_row, file + 1) == PieceOf('P', by)) return true;
+	for (auto& step : knight_steps)
+	{
+		if (PieceAt(row + step[0], file + step[1]) == PieceOf('N', by)) return true;
+	}
+	for (auto& step : king_steps)
+	{
+		if (PieceAt(row + step[0], file + step[1]) == PieceOf('K', by)) return true;
+		auto slider = PieceOf(step[0] != 0 && step[1] != 0 ? 'B' : 'R', by);
+		for (auto at_row = row + step[0], at_file = file + step[1]; OnBoard(at_row, at_file); at_row += step[0], at_file += step[1])
+		{
+			auto piece = brd[at_row * 8 + at_file];
+			if (piece == ' ') continue;
+			if (piece == slider || piece == PieceOf('Q', by)) return true;
+			break;
+		}
+	}
+	return false;
+}
+
+//squares a piece moves to from a square, stepping or sliding over empty squares, visit(square)
+template<typename Visit>
+void ForPieceMoves(const board& brd, char type, int from, Visit visit)
+{
+	auto row = from / 8;
+	auto file = from % 8;
+	auto& steps = type == 'N' ? knight_steps : king_steps;
+	for (auto& step : steps)
+	{
+		if (type == 'B' && (step[0] == 0 || step[1] == 0)) continue;
+		if (type == 'R' && step[0] != 0 && step[1] != 0) continue;
+		for (auto at_row = row + step[0], at_file = file + step[1]; OnBoard(at_row, at_file); at_row += step[0], at_file += step[1])
+		{
+			auto square = at_row * 8 + at_file;
+			visit(square);
+			if (type == 'K' || type == 'N' || brd[square] != ' ') break;
+		}
+	}
+}
+
+//king square of a color in a position
+auto KingSquare(const table_generator& generator, const tb_position& position, int color)
+{
+	return position.squares[color == white ? 0 : generator.black_king];
+}
+
+//legal moves of the side to move, visit(after, squares, leaves) where the squares are only
+//kept for moves that stay in the table, captures and promotions leave it
+template<typename Visit>
+void ForMoves(const table_generator& generator, const tb_position& position, Visit visit)
+{
+	auto& pieces = generator.layout.pieces;
+	for (auto slot = std::size_t{ 0 }; slot < pieces.size(); ++slot)
+	{
+		if (ColorOf(pieces[slot]) != position.color) continue;
+		auto from = position.squares[slot];
+		auto type = char(std::toupper(pieces[slot]));
+		auto Move = [&](int to, char placed)
+			{
+				auto after = position.brd;
+				auto leaves = after[to] != ' ' || placed != pieces[slot];
+				after[from] = ' ';
+				after[to] = placed;
+				if (Attacked(after, type == 'K' ? to : KingSquare(generator, position, position.color), -position.color)) return;
+				auto squares = position.squares;
+				squares[slot] = to;
+				visit(after, squares, leaves);
+			};
+		if (type != 'P')
+		{
+			ForPieceMoves(position.brd, type, from, [&](int to)
+				{
+					if (ColorOf(position.brd[to]) != position.color) Move(to, pieces[slot]);
+				});
+			continue;
+		}
+		auto forward = position.color == white ? -8 : 8;
+		auto Advance = [&](int to)
+			{
+				if (to / 8 != 0 && to / 8 != 7) Move(to, pieces[slot]);
+				else for (auto promoted : { 'Q', 'R', 'B', 'N' }) Move(to, PieceOf(promoted, position.color));
+			};
+		auto to = from + forward;
+		if (position.brd[to] == ' ')
+		{
+			Advance(to);
+			if (from / 8 == (position.color == white ? 6 : 1) && position.brd[to + forward] == ' ') Advance(to + forward);
+		}
+		for (auto side : { -1, 1 })
+		{
+			if (OnBoard(to / 8, to % 8 + side) && ColorOf(position.brd[to + side]) == -position.color) Advance(to + side);
+		}
+	}
+}
+
+//legal positions the side not to move came from, by moves staying in the table, visit(squares)
+template<typename Visit>
+void ForUnmoves(const table_generator& generator, const tb_position& position, Visit visit)
+{
+	auto& pieces = generator.layout.pieces;
+	auto mover = -position.color;
+	for (auto slot = std::size_t{ 0 }; slot < pieces.size(); ++slot)
+	{
+		if (ColorOf(pieces[slot]) != mover) continue;
+		auto to = position.squares[slot];
+		auto type = char(std::toupper(pieces[slot]));
+		auto Unmove = [&](int from)
+			{
+				//the side to move now can not have been in check with the mover to move
+				auto before = position.brd;
+				before[to] = ' ';
+				before[from] = pieces[slot];
+				if (Attacked(before, KingSquare(generator, position, position.color), mover)) return;
+				auto squares = position.squares;
+				squares[slot] = from;
+				visit(squares);
+			};
+		if (type != 'P')
+		{
+			ForPieceMoves(position.brd, type, to, [&](int from)
+				{
+					if (position.brd[from] == ' ') Unmove(from);
+				});
+			continue;
+		}
+		//pawns came from behind, not from the first row, and two rows from their starting row
+		auto backward = mover == white ? 8 : -8;
+		auto from = to + backward;
+		if (from / 8 == 0 || from / 8 == 7 || position.brd[from] != ' ') continue;
+		Unmove(from);
+		if (to / 8 == (mover == white ? 4 : 3) && position.brd[from + backward] == ' ') Unmove(from + backward);
+	}
+}
+
+//position of an index, false if it is not a legal position or not the one index of it
+auto Decode(const table_generator& generator, std::uint64_t index, tb_position& position)
+{
+	auto& layout = generator.layout;
+	position.color = index < layout.size ? white : black;
+	auto table_index = index % layout.size;
+	GeneratedSquares(layout, table_index, position.squares);
+	position.brd = board(64, ' ');
+	for (auto slot = std::size_t{ 0 }; slot < layout.pieces.size(); ++slot)
+	{
+		if (position.brd[position.squares[slot]] != ' ') return false;
+		position.brd[position.squares[slot]] = layout.pieces[slot];
+	}
+	if (GeneratedIndex(layout, position.squares) != table_index) return false;
+	return !Attacked(position.brd, KingSquare(generator, position, -position.color), position.color);
+}
+
+//index of the position of a color to move
+auto Encode(const table_generator& generator, const std::array<int, 7>& squares, int color)
+{
+	return GeneratedIndex(generator.layout, squares) + (color == black ? generator.layout.size : 0);
+}
+
+//keep the highest plies set or scheduled, so the levels run that far
+auto Raise(table_generator& generator, int plies)
+{
+	auto highest = generator.highest.load();
+	while (plies > highest && !generator.highest.compare_exchange_weak(highest, plies)) {}
+}
+
+//set the plies of an unknown position, false if it was known
+auto Resolve(table_generator& generator, std::uint64_t index, int plies)
+{
+	auto expected = tbgen::unknown;
+	if (!generator.plies[index].compare_exchange_strong(expected, static_cast<std::uint16_t>(plies))) return false;
+	Raise(generator, plies);
+	return true;
+}
+
+//run a function on every index, in chunks spread over threads
+template<typename Function>
+void ParallelFor(std::uint64_t count, int threads, Function function)
+{
+	auto next = std::atomic<std::uint64_t>{ 0 };
+	auto Work = [&]()
+		{
+			while (true)
+			{
+				auto first = next.fetch_add(tbgen::chunk);
+				if (first >= count) break;
+				auto last = std::min(first + tbgen::chunk, count);
+				for (auto index = first; index < last; ++index) function(index);
+			}
+		};
+	auto helpers = std::vector<std::thread>{};
+	for (auto thread = 1; thread < threads; ++thread) helpers.emplace_back(Work);
+	Work();
+	for (auto& helper : helpers) helper.join();
+}
+
+//mates, stalemates and the best move out of the table of each position, from the tables generated before
+auto Initialize(table_generator& generator, std::uint64_t index)
+{
+	auto position = tb_position{};
+	generator.pending[index] = tbgen::unknown;
+	generator.exits[index] = tbgen::unknown;
+	if (!Decode(generator, index, position))
+	{
+		generator.plies[index] = tbgen::broken;
+		return;
+	}
+	generator.plies[index] = tbgen::unknown;
+	auto moves = 0;
+	auto staying = 0;
+	auto exit_win = int(tbgen::unknown);
+	auto exit_draw = false;
+	auto exit_loss = -1;
+	ForMoves(generator, position, [&](const board& after, const std::array<int, 7>&, bool leaves)
+		{
+			++moves;
+			if (!leaves)
+			{
+				++staying;
+				return;
+			}
+			auto result = wdl::draw;
+			auto plies = 0;
+			if (!ProbeDTM(after, -position.color, result, plies)) generator.missing = true;
+			else if (result == wdl::loss) exit_win = std::min(exit_win, plies + 1);
+			else if (result == wdl::win) exit_loss = std::max(exit_loss, plies + 1);
+			else exit_draw = true;
+		});
+	if (moves == 0)
+	{
+		//mated, or stalemated
+		auto checked = Attacked(position.brd, KingSquare(generator, position, position.color), -position.color);
+		generator.plies[index] = checked ? 0 : tbgen::drawn;
+		return;
+	}
+	if (exit_win != tbgen::unknown)
+	{
+		generator.exits[index] = static_cast<std::uint16_t>(exit_win);
+		generator.pending[index] = static_cast<std::uint16_t>(exit_win);
+		Raise(generator, exit_win);
+	}
+	else if (exit_draw) generator.exits[index] = tbgen::drawn;
+	else if (exit_loss >= 0) generator.exits[index] = static_cast<std::uint16_t>(exit_loss);
+	if (staying != 0 || exit_win != tbgen::unknown) return;
+
+	//every move leaves the table
+	if (exit_draw) generator.plies[index] = tbgen::drawn;
+	else
+	{
+		generator.pending[index] = static_cast<std::uint16_t>(exit_loss);
+		Raise(generator, exit_loss);
+	}
+}
+
+//a position some of whose moves lead to wins of the opponent, lost if all of them do,
+//in the plies of the longest of them
+auto VerifyLoss(table_generator& generator, std::uint64_t index, int level)
+{
+	if (generator.plies[index] != tbgen::unknown) return;
+	auto exit = generator.exits[index];
+	if (exit == tbgen::drawn || (exit != tbgen::unknown && exit % 2 == 1)) return;
+	auto position = tb_position{};
+	if (!Decode(generator, index, position)) return;
+	auto lost = true;
+	auto longest = exit == tbgen::unknown ? 0 : exit - 1;
+	ForMoves(generator, position, [&](const board&, const std::array<int, 7>& squares, bool leaves)
+		{
+			if (leaves || !lost) return;
+			auto plies = generator.plies[Encode(generator, squares, -position.color)].load();
+			if (plies >= tbgen::resolved || plies % 2 == 0) lost = false;
+			else longest = std::max(longest, int(plies));
+		});
+	if (!lost) return;
+	if (longest + 1 == level + 1) Resolve(generator, index, level + 1);
+	else
+	{
+		generator.pending[index] = static_cast<std::uint16_t>(longest + 1);
+		Raise(generator, longest + 1);
+	}
+}
+
+//retrograde analysis, a ply at a time: the positions lost in a ply make the positions before them won
+//in one more, the positions won in a ply may make the positions before them lost
+auto Generate(table_generator& generator, int threads)
+{
+	ParallelFor(generator.positions, threads, [&](std::uint64_t index) { Initialize(generator, index); });
+	for (auto level = 0; level <= generator.highest; ++level)
+	{
+		ParallelFor(generator.positions, threads, [&](std::uint64_t index)
+			{
+				if (generator.pending[index] == level) Resolve(generator, index, level);
+			});
+		ParallelFor(generator.positions, threads, [&](std::uint64_t index)
+			{
+				if (generator.plies[index] != level) return;
+				auto position = tb_position{};
+				Decode(generator, index, position);
+				ForUnmoves(generator, position, [&](const std::array<int, 7>& squares)
+					{
+						auto before = Encode(generator, squares, -position.color);
+						if (level % 2 == 0) Resolve(generator, before, level + 1);
+						else VerifyLoss(generator, before, level);
+					});
+			});
+	}
+}
+
+//write the result and moves to mate files of a generated table
+auto WriteTable(const table_generator& generator, const std::string& directory)
+{
+	auto results = std::string((generator.positions + 3) / 4, '\0');
+	auto moves = std::string(generator.positions, '\0');
+	for (auto index = std::uint64_t{ 0 }; index < generator.positions; ++index)
+	{
+		auto plies = generator.plies[index].load();
+		auto value = generated::draw;
+		if (plies == tbgen::broken) value = generated::broken;
+		else if (plies < tbgen::resolved)
+		{
+			value = plies % 2 == 1 ? generated::win : generated::loss;
+			moves[index] = static_cast<char>(std::min((plies + 1) / 2, 255));
+		}
+		results[index / 4] |= static_cast<char>(value << (2 * (index % 4)));
+	}
+	auto path = directory + "/" + generator.layout.name;
+	auto wdl_file = std::ofstream(path + ".ctbw", std::ios::binary);
+	wdl_file.write(generated::wdl_magic, generated::magic_size);
+	wdl_file.write(results.data(), results.size());
+	auto dtm_file = std::ofstream(path + ".ctbm", std::ios::binary);
+	dtm_file.write(generated::dtm_magic, generated::magic_size);
+	dtm_file.write(moves.data(), moves.size());
+	return bool(wdl_file) && bool(dtm_file);
+}
+
+//generate and write one table, false if a table it moves into is missing or it can not be written
+auto GenerateTable(const std::string& name, const std::string& directory, int threads)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto generator = table_generator{};
+	generator.layout = GeneratedLayout(name);
+	generator.black_king = generator.layout.pieces.find('k');
+	generator.positions = 2 * generator.layout.size;
+	generator.plies.reset(new std::atomic<std::uint16_t>[generator.positions]);
+	generator.pending.reset(new std::atomic<std::uint16_t>[generator.positions]);
+	generator.exits.reset(new std::uint16_t[generator.positions]);
+	generator.highest = 0;
+	generator.missing = false;
+	Generate(generator, threads);
+	if (generator.missing) return false;
+
+	auto counts = std::array<std::uint64_t, 3>{};
+	auto longest = 0;
+	for (auto index = std::uint64_t{ 0 }; index < generator.positions; ++index)
+	{
+		auto plies = generator.plies[index].load();
+		if (plies == tbgen::broken) continue;
+		if (plies >= tbgen::resolved) ++counts[1];
+		else
+		{
+			++counts[plies % 2 == 1 ? 0 : 2];
+			longest = std::max(longest, int(plies));
+		}
+	}
+	auto written = WriteTable(generator, directory);
+	auto seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << ": " << counts[0] << " won, " << counts[1] << " drawn, " << counts[2] << " lost, longest mate "
+		<< (longest + 1) / 2 << " moves, " << seconds << "s" << std::endl;
+	return written;
+}
+
+//pieces other than the king of one side, strongest first
+void AddTableSides(std::vector<std::string>& sides, const std::string& side, std::size_t first, int count)
+{
+	sides.push_back(side);
+	if (count == 0) return;
+	auto pieces = std::string("QRBNP");
+	for (auto index = first; index < pieces.size(); ++index) AddTableSides(sides, side + pieces[index], index, count - 1);
+}
+
+//material value of a side, to name a table with the stronger side first
+auto SideValue(const std::string& side)
+{
+	auto value = 0;
+	for (auto piece : side)
+	{
+		value += piece == 'Q' ? 9 : piece == 'R' ? 5 : piece == 'B' || piece == 'N' ? 3 : piece == 'P' ? 1 : 0;
+	}
+	return value;
+}
+
+//every table name up to a number of pieces, ordered so the tables a table captures or promotes into come first
+auto TableNames(int pieces)
+{
+	auto sides = std::vector<std::string>{};
+	AddTableSides(sides, "K", 0, pieces - 2);
+	auto names = std::vector<std::string>{};
+	for (auto strong = std::size_t{ 0 }; strong < sides.size(); ++strong)
+	{
+		for (auto weak = strong; weak < sides.size(); ++weak)
+		{
+			auto& first = sides[strong];
+			auto& second = sides[weak];
+			if (first.size() + second.size() > static_cast<std::size_t>(pieces) || first.size() + second.size() == 2) continue;
+			if (SideValue(second) > SideValue(first)) names.push_back(second + "v" + first);
+			else names.push_back(first + "v" + second);
+		}
+	}
+	std::stable_sort(begin(names), end(names), [](const auto& name1, const auto& name2)
+		{
+			auto pawns1 = std::count(begin(name1), end(name1), 'P');
+			auto pawns2 = std::count(begin(name2), end(name2), 'P');
+			return name1.size() != name2.size() ? name1.size() < name2.size() : pawns1 < pawns2;
+		});
+	return names;
+}
+
+//tables of a number of pieces and of pawns do not move into each other, so they are generated together
+auto SameTier(const std::string& name1, const std::string& name2)
+{
+	return name1.size() == name2.size() && std::count(begin(name1), end(name1), 'P') == std::count(begin(name2), end(name2), 'P');
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: chesstogo-tbgen <directory> [pieces " << tbgen::default_pieces << ", at most "
+			<< tbgen::max_pieces << "] [threads]" << std::endl;
+		return 1;
+	}
+	auto directory = std::string(argv[1]);
+	auto pieces = argc > 2 ? std::max(3, std::min(std::atoi(argv[2]), tbgen::max_pieces)) : tbgen::default_pieces;
+	auto threads = argc > 3 ? std::max(1, std::atoi(argv[3])) : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	//a tier at a time, its tables spread over the threads and each table over its share of them,
+	//the tables of the tiers before mapped to look up the moves out of a table
+	auto names = TableNames(pieces);
+	for (auto first = std::size_t{ 0 }; first < names.size();)
+	{
+		auto last = first;
+		while (last < names.size() && SameTier(names[first], names[last])) ++last;
+		SetTablebasePath(directory);
+		auto workers = std::min(threads, static_cast<int>(last - first));
+		auto next = std::atomic<std::size_t>{ first };
+		auto failed = std::atomic<bool>{ false };
+		auto Work = [&]()
+			{
+				for (auto index = next++; index < last; index = next++)
+				{
+					if (GenerateTable(names[index], directory, std::max(1, threads / workers))) continue;
+					std::cerr << "could not generate " << names[index] << std::endl;
+					failed = true;
+				}
+			};
+		auto helpers = std::vector<std::thread>{};
+		for (auto worker = 1; worker < workers; ++worker) helpers.emplace_back(Work);
+		Work();
+		for (auto& helper : helpers) helper.join();
+		if (failed) return 1;
+		first = last;
+	}
+	std::cout << "generated " << names.size() << " tables in " << directory << std::endl;
+	return 0;
+}
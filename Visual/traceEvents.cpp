@@ -0,0 +1,176 @@
+/*
+    This code file contains the trace events declared in traceEvents.h,
+    each thread writing its own ring buffer without locks, the buffers only locked to add one or to write the trace.
+*/
+
+#include "traceEvents.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//an ended event, times in nanoseconds of the steady clock
+struct trace_event
+{
+	const char* name;
+	const char* arg_name;
+	std::int64_t start;
+	std::int64_t duration;
+	int arg;
+	int thread_id;
+};
+
+//the events of a thread, written only by that thread, the count published after each event
+struct trace_buffer
+{
+	std::array<trace_event, trace::buffer_events> events;
+	std::atomic<std::uint64_t> written{ 0 };
+	std::atomic<bool> in_use{ true };
+};
+
+//every buffer, those of ended threads kept for the trace and given to new threads
+std::mutex trace_mutex;
+std::vector<std::unique_ptr<trace_buffer>> trace_buffers;
+std::map<std::string, int> trace_thread_ids;
+std::atomic<int> next_trace_thread_id{ 1 };
+
+//recording, and the time the trace started
+std::atomic<bool> tracing{ false };
+std::atomic<std::int64_t> trace_start{ 0 };
+
+//steady clock now in nanoseconds
+auto TraceNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//the buffer of a thread, taken on its first event and given back when the thread ends
+struct thread_trace
+{
+	trace_buffer* buffer = nullptr;
+	int thread_id = 0;
+
+	~thread_trace()
+	{
+		if (buffer) buffer->in_use = false;
+	}
+};
+thread_local thread_trace this_thread_trace;
+
+//buffer of the calling thread, a free one or a new one the first time
+auto ThreadBuffer()
+{
+	auto& current = this_thread_trace;
+	if (current.buffer) return current.buffer;
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	for (auto& buffer : trace_buffers)
+	{
+		if (buffer->in_use) continue;
+		buffer->in_use = true;
+		current.buffer = buffer.get();
+		break;
+	}
+	if (!current.buffer)
+	{
+		trace_buffers.push_back(std::make_unique<trace_buffer>());
+		current.buffer = trace_buffers.back().get();
+	}
+	if (current.thread_id == 0) current.thread_id = next_trace_thread_id++;
+	return current.buffer;
+}
+
+trace_scope::trace_scope(const char* name, const char* arg_name, int arg)
+	: name(name), arg_name(arg_name), arg(arg), start(tracing.load(std::memory_order_relaxed) ? TraceNow() : -1)
+{
+}
+
+trace_scope::~trace_scope()
+{
+	if (start < 0) return;
+	auto buffer = ThreadBuffer();
+	auto written = buffer->written.load(std::memory_order_relaxed);
+	buffer->events[written % trace::buffer_events] = trace_event{ name, arg_name, start, TraceNow() - start, arg, this_thread_trace.thread_id };
+	buffer->written.store(written + 1, std::memory_order_release);
+}
+
+//name the calling thread on the timeline
+void NameTraceThread(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	auto found = trace_thread_ids.find(name);
+	if (found == end(trace_thread_ids)) found = trace_thread_ids.emplace(name, next_trace_thread_id++).first;
+	this_thread_trace.thread_id = found->second;
+}
+
+//test if events are being recorded
+bool Tracing()
+{
+	return tracing;
+}
+
+//record events from now on
+void StartTrace()
+{
+	trace_start = TraceNow();
+	tracing = true;
+}
+
+//a string of json, quoted and escaped
+auto JsonString(const std::string& text)
+{
+	auto quoted = std::string("\"");
+	for (auto character : text)
+	{
+		if (character == '"' || character == '\\') quoted += '\\';
+		quoted += character;
+	}
+	return quoted + "\"";
+}
+
+//stop recording and write the events since the start as chrome trace event json
+bool WriteTrace(const std::string& path)
+{
+	tracing = false;
+	auto file = std::ofstream(path);
+	if (!file) return false;
+	std::lock_guard<std::mutex> lock(trace_mutex);
+
+	//complete events in microseconds since the start, after a name for each named thread
+	auto first = true;
+	auto separator = [&]()
+		{
+			auto text = first ? "\n" : ",\n";
+			first = false;
+			return text;
+		};
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (auto& thread : trace_thread_ids)
+	{
+		file << separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.second
+			<< ",\"args\":{\"name\":" << JsonString(thread.first) << "}}";
+	}
+	auto start = trace_start.load();
+	file << std::fixed << std::setprecision(3);
+	for (auto& buffer : trace_buffers)
+	{
+		auto written = buffer->written.load(std::memory_order_acquire);
+		auto kept = std::min<std::uint64_t>(written, trace::buffer_events);
+		for (auto index = written - kept; index < written; ++index)
+		{
+			auto& event = buffer->events[index % trace::buffer_events];
+			if (event.start < start) continue;
+			file << separator() << "{\"name\":" << JsonString(event.name) << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id
+				<< ",\"ts\":" << (event.start - start) / 1000.0 << ",\"dur\":" << event.duration / 1000.0;
+			if (event.arg_name) file << ",\"args\":{" << JsonString(event.arg_name) << ":" << event.arg << "}";
+			file << "}";
+		}
+	}
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
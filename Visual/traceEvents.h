@@ -0,0 +1,48 @@
+/*
+    This header file contains the trace events, a timeline of scoped events of the search and the gui,
+    recorded per thread into ring buffers while tracing and written as chrome trace event json.
+*/
+
+#ifndef _TRACE_EVENTS_H
+#define _TRACE_EVENTS_H
+
+#include <cstdint>
+#include <string>
+
+//trace parameters, events kept per thread, the oldest overwritten
+namespace trace {
+  const int buffer_events = 1 << 13;
+}
+
+//an event of the timeline from its construction to its destruction, recorded on its thread when it ends
+//if tracing was on when it started, an argument like the depth shown with it if it has a name,
+//the names must outlive the trace, like string literals
+class trace_scope
+{
+public:
+	trace_scope(const char* name, const char* arg_name = nullptr, int arg = 0);
+	~trace_scope();
+	trace_scope(const trace_scope&) = delete;
+	trace_scope& operator=(const trace_scope&) = delete;
+
+private:
+	const char* name;
+	const char* arg_name;
+	int arg;
+	std::int64_t start;
+};
+
+//name the calling thread on the timeline, threads of the same name share a row, like the helpers of each search
+void NameTraceThread(const std::string& name);
+
+//test if events are being recorded
+bool Tracing();
+
+//record events from now on, those before are left out of the trace
+void StartTrace();
+
+//stop recording and write the events since the start as chrome trace event json, for chrome://tracing or perfetto,
+//false if the file can not be written
+bool WriteTrace(const std::string& path);
+
+#endif
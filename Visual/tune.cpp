@@ -0,0 +1,437 @@
+/*
+    This code file contains the tune tool, texel tuning of the evaluation weights
+    from positions labeled with their game result, rewriting evaluationMap.h.
+*/
+
+#include "engine.h"
+#include "evaluationMap.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//tuning parameters
+namespace tuning {
+  const int quiesce_depth   = 8;
+  const int load_chunk      = 1 << 16;
+  const int batch_size      = 1 << 14;
+  const int default_epochs  = 100;
+  const float learning_rate = 1.0f;
+  const float beta1         = 0.9f;
+  const float beta2         = 0.999f;
+  const float epsilon       = 1e-8f;
+}
+
+//game phase weights and the full midgame phase, as in the engine
+const int phase_weights[6] = { 0, 1, 1, 2, 4, 0 };
+const int midgame_phase = 24;
+
+//piece types in weight order
+const std::string piece_names[6] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+const std::string white_pieces = "PNBRQK";
+const std::string black_pieces = "pnbrqk";
+
+//weight vector layout, midgame and endgame tables of each piece type then midgame and endgame values
+const int table_weights = 6 * 2 * 64;
+const int weight_count = table_weights + 6 * 2;
+
+auto MidgameTable(int type) { return type * 128; }
+auto EndgameTable(int type) { return type * 128 + 64; }
+auto MidgameValue(int type) { return table_weights + type * 2; }
+auto EndgameValue(int type) { return table_weights + type * 2 + 1; }
+
+//a tuning position reduced to the quiet board its capture sequence ends on, stored as its piece list,
+//each piece is bit 15 black, piece type << 6 and the table index (mirrored for black),
+//offset is the start of the pieces in the shared piece list
+struct tune_position
+{
+	std::uint32_t offset;
+	std::uint8_t count;
+	std::uint8_t phase;
+	std::int16_t constant;
+	float result;
+};
+
+struct tune_set
+{
+	std::vector<tune_position> positions;
+	std::vector<std::uint16_t> pieces;
+};
+
+//game result of a labeled line, 1 white won, 0 black won, -1 if none found
+auto ParseResult(const std::string& line)
+{
+	if (line.find("1/2-1/2") != std::string::npos || line.find("[0.5]") != std::string::npos) return 0.5f;
+	if (line.find("1-0") != std::string::npos || line.find("[1.0]") != std::string::npos || line.find("[1]") != std::string::npos) return 1.0f;
+	if (line.find("0-1") != std::string::npos || line.find("[0.0]") != std::string::npos || line.find("[0]") != std::string::npos) return 0.0f;
+	return -1.0f;
+}
+
+//capture only search from a position, returns its score and leaves the quiet board the best capture sequence ends on
+int Quiesce(const board& brd, int color, int alpha, int beta, int depth, board& leaf)
+{
+	leaf = brd;
+	auto stand_pat = GetEvaluation(brd, color);
+	if (stand_pat >= beta) return beta;
+	alpha = std::max(alpha, stand_pat);
+	if (depth == 0) return alpha;
+	auto next_boards = GetAllMoves(brd, color);
+	std::sort(begin(next_boards), end(next_boards), [](const auto& brd1, const auto& brd2)
+		{
+			return brd1.score > brd2.score;
+		});
+	auto next_leaf = board{};
+	for (auto& next : next_boards)
+	{
+		if (next.captured == ' ') continue;
+		auto score = -Quiesce(next.brd, -color, -beta, -alpha, depth - 1, next_leaf);
+		if (score >= beta)
+		{
+			leaf = next_leaf;
+			return beta;
+		}
+		if (score > alpha)
+		{
+			alpha = score;
+			leaf = next_leaf;
+		}
+	}
+	return alpha;
+}
+
+//model score of a position for the weights, from whites point of view, without its constant
+auto ModelScore(const tune_set& set, const tune_position& position, const std::vector<float>& weights)
+{
+	auto midgame = 0.0f;
+	auto endgame = 0.0f;
+	for (auto index = position.offset; index < position.offset + position.count; ++index)
+	{
+		auto piece = set.pieces[index];
+		auto sign = (piece & 0x8000) ? -1.0f : 1.0f;
+		auto type = (piece >> 6) & 7;
+		auto square = piece & 63;
+		midgame += sign * (weights[MidgameValue(type)] + weights[MidgameTable(type) + square]);
+		endgame += sign * (weights[EndgameValue(type)] + weights[EndgameTable(type) + square]);
+	}
+	return (midgame * position.phase + endgame * (midgame_phase - position.phase)) / midgame_phase;
+}
+
+//weights of the current evaluationMap.h, king values are always 0
+auto InitialWeights()
+{
+	const std::array<int, 64>* midgame_tables[6] = { &evaluationMap::pawn, &evaluationMap::knight, &evaluationMap::bishop,
+		&evaluationMap::rook, &evaluationMap::queen, &evaluationMap::king };
+	const std::array<int, 64>* endgame_tables[6] = { &evaluationMap::pawn_endgame, &evaluationMap::knight_endgame, &evaluationMap::bishop_endgame,
+		&evaluationMap::rook_endgame, &evaluationMap::queen_endgame, &evaluationMap::king_endgame };
+	const int midgame_values[6] = { midgame_value_of::pawn, midgame_value_of::knight, midgame_value_of::bishop,
+		midgame_value_of::rook, midgame_value_of::queen, 0 };
+	const int endgame_values[6] = { endgame_value_of::pawn, endgame_value_of::knight, endgame_value_of::bishop,
+		endgame_value_of::rook, endgame_value_of::queen, 0 };
+	auto weights = std::vector<float>(weight_count);
+	for (auto type = 0; type < 6; ++type)
+	{
+		for (auto square = 0; square < 64; ++square)
+		{
+			weights[MidgameTable(type) + square] = float((*midgame_tables[type])[square]);
+			weights[EndgameTable(type) + square] = float((*endgame_tables[type])[square]);
+		}
+		weights[MidgameValue(type)] = float(midgame_values[type]);
+		weights[EndgameValue(type)] = float(endgame_values[type]);
+	}
+	return weights;
+}
+
+//weights that are never used, kings are never taken and pawns never stand on the first or last row
+auto Frozen(int weight)
+{
+	if (weight == MidgameValue(5) || weight == EndgameValue(5)) return true;
+	if (weight < table_weights && weight / 128 == 0)
+	{
+		auto row = (weight % 64) / 8;
+		return row == 0 || row == 7;
+	}
+	return false;
+}
+
+//reduce a labeled board to its quiet leaf and piece list, appended to the set
+auto AddPosition(tune_set& set, const board& leaf, float result, const std::vector<float>& weights)
+{
+	auto position = tune_position{ static_cast<std::uint32_t>(set.pieces.size()), 0, 0, 0, result };
+	auto phase = 0;
+	for (auto index = 0; index < 64; ++index)
+	{
+		auto piece = leaf[index];
+		if (piece == ' ') continue;
+		auto type = white_pieces.find(piece);
+		auto black_piece = (type == std::string::npos);
+		if (black_piece) type = black_pieces.find(piece);
+		auto square = black_piece ? 63 - index : index;
+		set.pieces.push_back(static_cast<std::uint16_t>((black_piece ? 0x8000 : 0) | (type << 6) | square));
+		phase += phase_weights[type];
+		++position.count;
+	}
+	position.phase = static_cast<std::uint8_t>(std::min(phase, midgame_phase));
+	//whatever the evaluation adds besides the tuned weights, pawn structure and the like, kept fixed
+	auto constant = GetEvaluation(leaf, white) - ModelScore(set, position, weights);
+	position.constant = static_cast<std::int16_t>(std::max(-32767.0f, std::min(32767.0f, std::round(constant))));
+	set.positions.push_back(position);
+}
+
+//load labeled positions, one fen and result per line, resolving them to quiet boards on all threads
+auto LoadPositions(const std::string& path, int threads, const std::vector<float>& weights)
+{
+	auto set = tune_set{};
+	auto file = mapped_file(path);
+	auto text = reinterpret_cast<const char*>(file.data());
+	auto end = text + file.size();
+	struct labeled { board brd; int color; float result; };
+	auto chunk = std::vector<labeled>{};
+	auto resolve = [&]()
+	{
+		auto leaves = boards(chunk.size());
+		auto workers = std::vector<std::thread>{};
+		for (auto thread = 0; thread < threads; ++thread)
+		{
+			workers.emplace_back([&, thread]()
+				{
+					for (auto index = std::size_t(thread); index < chunk.size(); index += threads)
+					{
+						Quiesce(chunk[index].brd, chunk[index].color, -value_of::mate, value_of::mate, tuning::quiesce_depth, leaves[index]);
+					}
+				});
+		}
+		for (auto& worker : workers) worker.join();
+		for (auto index = std::size_t{ 0 }; index < chunk.size(); ++index) AddPosition(set, leaves[index], chunk[index].result, weights);
+		chunk.clear();
+	};
+	while (text < end)
+	{
+		auto line_end = std::find(text, end, '\n');
+		auto line = std::string(text, line_end);
+		text = (line_end == end) ? end : line_end + 1;
+		auto result = ParseResult(line);
+		if (result < 0) continue;
+		auto entry = labeled{ board{}, white, result };
+		ParseFen(line, entry.brd, entry.color);
+		if (std::count(begin(entry.brd), std::end(entry.brd), 'K') != 1 || std::count(begin(entry.brd), std::end(entry.brd), 'k') != 1) continue;
+		chunk.push_back(entry);
+		if (static_cast<int>(chunk.size()) == tuning::load_chunk) resolve();
+	}
+	resolve();
+	return set;
+}
+
+//win probability of a white score, scaled by k
+auto Sigmoid(float score, float k)
+{
+	return 1.0f / (1.0f + std::pow(10.0f, -k * score / 400.0f));
+}
+
+//mean squared error of the predicted results of positions first to last, summed over all threads
+auto Loss(const tune_set& set, const std::vector<float>& weights, float k, int threads)
+{
+	auto sums = std::vector<double>(threads);
+	auto workers = std::vector<std::thread>{};
+	for (auto thread = 0; thread < threads; ++thread)
+	{
+		workers.emplace_back([&, thread]()
+			{
+				for (auto index = std::size_t(thread); index < set.positions.size(); index += threads)
+				{
+					auto& position = set.positions[index];
+					auto error = position.result - Sigmoid(ModelScore(set, position, weights) + position.constant, k);
+					sums[thread] += error * error;
+				}
+			});
+	}
+	for (auto& worker : workers) worker.join();
+	auto sum = 0.0;
+	for (auto value : sums) sum += value;
+	return sum / std::max<std::size_t>(set.positions.size(), 1);
+}
+
+//scaling of scores to win probability that best fits the current weights
+auto FitK(const tune_set& set, const std::vector<float>& weights, int threads)
+{
+	//golden section search, the loss is smooth in k
+	auto low = 0.1f;
+	auto high = 3.0f;
+	const auto ratio = 0.618034f;
+	for (auto step = 0; step < 30; ++step)
+	{
+		auto k1 = high - ratio * (high - low);
+		auto k2 = low + ratio * (high - low);
+		if (Loss(set, weights, k1, threads) < Loss(set, weights, k2, threads)) high = k2;
+		else low = k1;
+	}
+	return (low + high) / 2;
+}
+
+//gradient of the loss over positions first to last, split over the threads
+auto Gradient(const tune_set& set, std::size_t first, std::size_t last, const std::vector<float>& weights, float k, int threads,
+	std::vector<std::vector<float>>& gradients)
+{
+	auto workers = std::vector<std::thread>{};
+	for (auto thread = 0; thread < threads; ++thread)
+	{
+		workers.emplace_back([&, thread]()
+			{
+				auto& gradient = gradients[thread];
+				std::fill(begin(gradient), end(gradient), 0.0f);
+				for (auto index = first + thread; index < last; index += threads)
+				{
+					auto& position = set.positions[index];
+					auto predicted = Sigmoid(ModelScore(set, position, weights) + position.constant, k);
+					//derivative of the squared error through the sigmoid, per score point
+					auto slope = (predicted - position.result) * predicted * (1 - predicted) * k * std::log(10.0f) / 400.0f;
+					auto midgame = slope * position.phase / midgame_phase;
+					auto endgame = slope * (midgame_phase - position.phase) / midgame_phase;
+					for (auto piece_index = position.offset; piece_index < position.offset + position.count; ++piece_index)
+					{
+						auto piece = set.pieces[piece_index];
+						auto sign = (piece & 0x8000) ? -1.0f : 1.0f;
+						auto type = (piece >> 6) & 7;
+						auto square = piece & 63;
+						gradient[MidgameTable(type) + square] += sign * midgame;
+						gradient[EndgameTable(type) + square] += sign * endgame;
+						gradient[MidgameValue(type)] += sign * midgame;
+						gradient[EndgameValue(type)] += sign * endgame;
+					}
+				}
+			});
+	}
+	for (auto& worker : workers) worker.join();
+	for (auto thread = 1; thread < threads; ++thread)
+	{
+		for (auto weight = 0; weight < weight_count; ++weight) gradients[0][weight] += gradients[thread][weight];
+	}
+}
+
+//one piece square table of the generated header
+auto TableText(const std::vector<float>& weights, int start, const std::string& name, const std::string& comment)
+{
+	auto text = "//" + comment + "\nconstexpr std::array<int, 64> " + name + " = {{\n";
+	for (auto row = 0; row < 8; ++row)
+	{
+		text += "\t";
+		for (auto column = 0; column < 8; ++column)
+		{
+			char value[16];
+			std::snprintf(value, sizeof(value), "%4d", int(std::lround(weights[start + row * 8 + column])));
+			text += value;
+			if (row * 8 + column != 63) text += ",";
+		}
+		text += (row == 7) ? "}};\n" : "\n";
+	}
+	return text;
+}
+
+//write the weights as evaluationMap.h
+auto WriteHeader(const std::string& path, const std::vector<float>& weights)
+{
+	auto value = [&](int weight) { return std::to_string(std::lround(weights[weight])); };
+	auto text = std::string(
+		"/*\n"
+		"    This header file contains the evaluation weights, piece values and\n"
+		"    piece square tables for the midgame and endgame, rewritten by the tune tool.\n"
+		"*/\n"
+		"\n"
+		"#ifndef _EVALUATION_MAP_H\n"
+		"#define _EVALUATION_MAP_H\n"
+		"\n"
+		"#include <array>\n"
+		"\n");
+	const char* phases[2] = { "midgame", "endgame" };
+	for (auto phase = 0; phase < 2; ++phase)
+	{
+		auto weight_of = [&](int type) { return (phase == 0) ? MidgameValue(type) : EndgameValue(type); };
+		text += std::string("//piece values in the ") + phases[phase] + ", in centipawns\n";
+		text += std::string("namespace ") + phases[phase] + "_value_of {\n";
+		text += "  const int queen  = " + value(weight_of(4)) + ";\n";
+		text += "  const int rook   = " + value(weight_of(3)) + ";\n";
+		text += "  const int bishop = " + value(weight_of(2)) + ";\n";
+		text += "  const int knight = " + value(weight_of(1)) + ";\n";
+		text += "  const int pawn   = " + value(weight_of(0)) + ";\n";
+		text += "}\n\n";
+	}
+	text += "//piece square tables, row 0 is rank 8 seen from white\nnamespace evaluationMap {\n";
+	for (auto type = 0; type < 6; ++type)
+	{
+		if (type > 0) text += "\n";
+		text += TableText(weights, MidgameTable(type), piece_names[type], piece_names[type] + " values for position in the midgame");
+	}
+	for (auto type = 0; type < 6; ++type)
+	{
+		text += "\n" + TableText(weights, EndgameTable(type), piece_names[type] + "_endgame", piece_names[type] + " values for position in the endgame");
+	}
+	text += "}\n\n#endif\n";
+	auto out = std::ofstream(path, std::ios::binary);
+	out << text;
+	return bool(out);
+}
+
+int main(int argc, const char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: chesstogo-tune <positions> [header, default evaluationMap.h] [epochs] [threads]\n"
+			<< "each line of positions is a fen and a game result, 1-0, 0-1, 1/2-1/2 or [1.0], [0.0], [0.5]\n";
+		return 1;
+	}
+	auto output = (argc > 2) ? std::string(argv[2]) : std::string("evaluationMap.h");
+	auto epochs = (argc > 3) ? std::atoi(argv[3]) : tuning::default_epochs;
+	auto threads = (argc > 4) ? std::atoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency());
+	threads = std::max(threads, 1);
+
+	auto weights = InitialWeights();
+	auto start = std::chrono::high_resolution_clock::now();
+	auto set = LoadPositions(argv[1], threads, weights);
+	std::chrono::duration<float> load_time = std::chrono::high_resolution_clock::now() - start;
+	std::cout << set.positions.size() << " positions loaded in " << load_time.count() << "s" << std::endl;
+	if (set.positions.empty()) return 1;
+
+	auto k = FitK(set, weights, threads);
+	std::cout << "k " << k << " loss " << Loss(set, weights, k, threads) << std::endl;
+
+	//adam over mini batches of the positions in file order
+	auto gradients = std::vector<std::vector<float>>(threads, std::vector<float>(weight_count));
+	auto moment = std::vector<float>(weight_count);
+	auto velocity = std::vector<float>(weight_count);
+	auto step = 0;
+	for (auto epoch = 1; epoch <= epochs; ++epoch)
+	{
+		for (auto first = std::size_t{ 0 }; first < set.positions.size(); first += tuning::batch_size)
+		{
+			auto last = std::min(first + tuning::batch_size, set.positions.size());
+			Gradient(set, first, last, weights, k, threads, gradients);
+			++step;
+			auto& gradient = gradients[0];
+			for (auto weight = 0; weight < weight_count; ++weight)
+			{
+				if (Frozen(weight)) continue;
+				auto mean = gradient[weight] / float(last - first);
+				moment[weight] = tuning::beta1 * moment[weight] + (1 - tuning::beta1) * mean;
+				velocity[weight] = tuning::beta2 * velocity[weight] + (1 - tuning::beta2) * mean * mean;
+				auto corrected_moment = moment[weight] / (1 - std::pow(tuning::beta1, float(step)));
+				auto corrected_velocity = velocity[weight] / (1 - std::pow(tuning::beta2, float(step)));
+				weights[weight] -= tuning::learning_rate * corrected_moment / (std::sqrt(corrected_velocity) + tuning::epsilon);
+			}
+		}
+		std::chrono::duration<float> elapsed = std::chrono::high_resolution_clock::now() - start;
+		std::cout << "epoch " << epoch << " loss " << Loss(set, weights, k, threads) << " time " << elapsed.count() << "s" << std::endl;
+	}
+	if (!WriteHeader(output, weights))
+	{
+		std::cerr << "can not write " << output << "\n";
+		return 1;
+	}
+	std::cout << "weights written to " << output << std::endl;
+	return 0;
+}
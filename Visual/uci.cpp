@@ -0,0 +1,490 @@
+/*
+    This code file contains the UCI protocol front-end,
+    driving the engine over stdin/stdout without SFML.
+*/
+
+#include "engine.h"
+#include "allocTracker.h"
+#include "book.h"
+#include "explorer.h"
+#include "infoSink.h"
+#include "perfCounters.h"
+#include "traceEvents.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cctype>
+#include <cstdlib>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+//uci option ranges
+namespace option {
+  const int max_hash_mb = 4096;
+  const int max_threads = 256;
+  const int max_multi_pv = 64;
+}
+
+//clock safety margin and moves assumed left when the gui does not say, for time management
+namespace clock_of {
+  const float margin    = 0.05f;
+  const int moves_to_go = 30;
+}
+
+const auto start_position = board("rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR");
+
+//parameters of a go command, times are in milliseconds
+struct go_params
+{
+	int wtime = -1;
+	int btime = -1;
+	int winc = 0;
+	int binc = 0;
+	int movestogo = 0;
+	int movetime = -1;
+	int depth = -1;
+	std::uint64_t nodes = 0;
+	bool infinite = false;
+	bool ponder = false;
+};
+
+//board index of a square name like "e2", row 0 of the board is rank 8
+auto SquareIndex(const std::string& square)
+{
+	return (8 - (square[1] - '0')) * 8 + (square[0] - 'a');
+}
+
+//play a uci move like "e2e4" or "e7e8q", moving the rook when castling and removing a pawn taken en passant
+auto ApplyMove(board& brd, const std::string& move)
+{
+	auto from = SquareIndex(move.substr(0, 2));
+	auto to = SquareIndex(move.substr(2, 2));
+	auto piece = brd[from];
+	if ((piece == 'K' || piece == 'k') && std::abs(to - from) == 2)
+	{
+		//castling, the rook jumps over the king
+		auto rook_from = (to > from) ? from + 3 : from - 4;
+		brd[(from + to) / 2] = brd[rook_from];
+		brd[rook_from] = ' ';
+	}
+	if ((piece == 'P' || piece == 'p') && (to - from) % 8 != 0 && brd[to] == ' ')
+	{
+		//en passant, the captured pawn is beside the from square
+		brd[(from / 8) * 8 + to % 8] = ' ';
+	}
+	brd[to] = piece;
+	brd[from] = ' ';
+	if (move.size() > 4)
+	{
+		brd[to] = (piece == 'P') ? char(std::toupper(move[4])) : char(std::tolower(move[4]));
+	}
+}
+
+//seconds to spend on this move, a share of the remaining clock plus most of the increment
+auto MoveTime(const go_params& go, int color)
+{
+	if (go.movetime >= 0) return go.movetime / 1000.0f;
+	auto remaining = (color == white) ? go.wtime : go.btime;
+	auto increment = (color == white) ? go.winc : go.binc;
+	if (remaining < 0) return control::max_time_per_move;
+	auto moves_to_go = (go.movestogo > 0) ? go.movestogo : clock_of::moves_to_go;
+	auto time = (remaining / float(moves_to_go) + increment * 0.75f) / 1000.0f;
+	time = std::min(time, remaining / 1000.0f - clock_of::margin);
+	return std::max(time, 0.01f);
+}
+
+//uci session, the position being set up and the search running on it, output lines are written
+//by both the input and search threads so all go through the sink
+struct session
+{
+	info_sink output{ std::cout };
+	board brd = start_position;
+	int color = white;
+	boards history;
+	std::thread search;
+	std::atomic<bool> stop{ false };
+	std::atomic<bool> wait_for_stop{ false };
+	float ponder_time = 0;
+	int multi_pv = 1;
+	int hash_mb = control::hash_size_mb;
+	int threads = 1;
+};
+
+auto StopSearch(session& uci)
+{
+	if (!uci.search.joinable()) return;
+	uci.stop = true;
+	uci.search.join();
+}
+
+//position [startpos | fen <fen>] [moves <move>...]
+auto SetPosition(session& uci, std::istringstream& input)
+{
+	auto token = std::string{};
+	input >> token;
+	if (token == "fen")
+	{
+		auto fen = std::string{};
+		while (input >> token && token != "moves") fen += token + " ";
+		ParseFen(fen, uci.brd, uci.color);
+	}
+	else
+	{
+		uci.brd = start_position;
+		uci.color = white;
+		input >> token;
+	}
+	uci.history.clear();
+	while (input >> token)
+	{
+		ApplyMove(uci.brd, token);
+		uci.color = -uci.color;
+		uci.history.push_back(uci.brd);
+	}
+}
+
+//go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [movetime <ms>] [depth <n>] [nodes <n>] [infinite] [ponder]
+auto Go(session& uci, std::istringstream& input)
+{
+	StopSearch(uci);
+	auto go = go_params{};
+	auto token = std::string{};
+	while (input >> token)
+	{
+		if (token == "wtime") input >> go.wtime;
+		else if (token == "btime") input >> go.btime;
+		else if (token == "winc") input >> go.winc;
+		else if (token == "binc") input >> go.binc;
+		else if (token == "movestogo") input >> go.movestogo;
+		else if (token == "movetime") input >> go.movetime;
+		else if (token == "depth") input >> go.depth;
+		else if (token == "nodes") input >> go.nodes;
+		else if (token == "infinite") go.infinite = true;
+		else if (token == "ponder") go.ponder = true;
+	}
+	auto limits = search_limits{};
+	limits.time = MoveTime(go, uci.color);
+	if (go.depth > 0) limits.ply = std::max(1, std::min(go.depth - 1, control::max_ply));
+	limits.nodes = go.nodes;
+	auto clock = (uci.color == white) ? go.wtime : go.btime;
+	if ((go.depth > 0 || go.nodes > 0) && clock < 0 && go.movetime < 0)
+	{
+		//a depth or node limit alone is not timed
+		limits.time = std::numeric_limits<float>::infinity();
+	}
+	if (go.infinite || go.ponder)
+	{
+		//no time limit until ponderhit or stop
+		uci.ponder_time = limits.time;
+		limits.time = std::numeric_limits<float>::infinity();
+	}
+	limits.multi_pv = uci.multi_pv;
+	limits.stop = &uci.stop;
+	uci.stop = false;
+	uci.wait_for_stop = go.infinite || go.ponder;
+	uci.search = std::thread([&uci, limits]()
+		{
+			NameTraceThread("search 0");
+			auto pv = boards{};
+			auto root = uci.brd;
+			auto post = uci.output.Reporter(root);
+			auto report = [&](const search_info& info)
+			{
+				if (info.multi_pv == 1) pv = info.pv;
+				post(info);
+			};
+			auto best = GetBestMove(uci.brd, uci.color, uci.history, limits, report);
+
+			//uci forbids sending bestmove while pondering or in infinite mode before being told
+			while (uci.wait_for_stop && !uci.stop) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			if (best.empty())
+			{
+				uci.output.Send("bestmove 0000");
+				return;
+			}
+			auto line = "bestmove " + MoveName(root, best);
+			if (pv.size() > 1 && pv[0] == best) line += " ponder " + MoveName(pv[0], pv[1]);
+			uci.output.Send(line);
+		});
+}
+
+//setoption name <id> value <x>
+auto SetOption(session& uci, std::istringstream& input)
+{
+	auto token = std::string{};
+	auto name = std::string{};
+	auto text = std::string{};
+	input >> token >> name >> token;
+	std::getline(input >> std::ws, text);
+	auto value = std::atoi(text.c_str());
+	StopSearch(uci);
+	if (name == "Hash")
+	{
+		uci.hash_mb = std::max(1, std::min(value, option::max_hash_mb));
+		SetHashSize(uci.hash_mb);
+	}
+	else if (name == "Threads")
+	{
+		uci.threads = std::max(1, std::min(value, option::max_threads));
+		SetThreads(uci.threads);
+	}
+	else if (name == "MultiPV") uci.multi_pv = std::max(1, std::min(value, option::max_multi_pv));
+	else if (name == "EvalFile")
+	{
+		//an empty or missing file goes back to the piece square tables
+		auto loaded = LoadNetwork(text);
+		ClearHash();
+		uci.output.Send(std::string("info string ") + (loaded ? "evaluating with network " + text : "evaluating with piece square tables"));
+	}
+	else if (name == "SyzygyPath")
+	{
+		//scores in the hash table are from before the tables
+		auto pieces = SetTablebasePath(text == "<empty>" ? std::string{} : text);
+		ClearHash();
+		uci.output.Send("info string tablebases up to " + std::to_string(pieces) + " pieces");
+	}
+	else if (name == "BookFile")
+	{
+		auto loaded = LoadBook(text == "<empty>" ? std::string{} : text);
+		uci.output.Send(std::string("info string ") + (loaded ? "playing from book " + text : "playing without a book"));
+	}
+	else if (name == "BookVariety") SetBookVariety(value);
+	else if (name == "ExplorerFile")
+	{
+		auto loaded = LoadExplorer(text == "<empty>" ? std::string{} : text);
+		uci.output.Send(std::string("info string ") + (loaded ? "exploring " + text : "exploring no games"));
+	}
+}
+
+//explore, not a uci command, the results of the games that reached the position and the moves played from it
+auto Explore(session& uci)
+{
+	auto found = explored_position{};
+	if (!ExplorePosition(uci.brd, uci.color, uci.history, found))
+	{
+		uci.output.Send("info string no games");
+		return;
+	}
+	auto& position = *found.position;
+	uci.output.Send("info string games " + std::to_string(position.games) + " wins " + std::to_string(position.wins)
+		+ " draws " + std::to_string(position.draws) + " losses " + std::to_string(position.losses));
+	for (auto move = found.moves; move != found.moves + position.moves; ++move)
+	{
+		uci.output.Send("info string move " + PolyglotMoveName(uci.brd, move->move) + " games " + std::to_string(move->games)
+			+ " wins " + std::to_string(move->wins) + " draws " + std::to_string(move->draws) + " losses " + std::to_string(move->losses));
+	}
+}
+
+//hardware counts per million nodes, "perf per million nodes cycles .. ipc .."
+auto PerfLine(const perf_counts& perf, std::uint64_t nodes)
+{
+	static const char* const names[perf_events] = { "cycles", "instructions", "l1-misses", "llc-misses", "branch-misses", "dtlb-misses" };
+	auto millions = std::max<std::uint64_t>(nodes, 1) / 1e6;
+	auto line = std::string("perf per million nodes");
+	for (auto event = 0; event < perf_events; ++event)
+	{
+		if (perf.counted[event]) line += std::string(" ") + names[event] + " " + std::to_string(static_cast<std::uint64_t>(perf.counts[event] / millions));
+	}
+	if (perf.counted[perf_cycles] && perf.counted[perf_instructions] && perf.counts[perf_cycles] > 0)
+	{
+		line += " ipc " + std::to_string(double(perf.counts[perf_instructions]) / perf.counts[perf_cycles]);
+	}
+	return line;
+}
+
+//the performance counters of a run, or why there are none in a performance counter build
+auto SendPerf(info_sink& output, const std::string& run, bool counting, const perf_counts& perf, std::uint64_t nodes)
+{
+	if (counting) output.Send(run + " " + PerfLine(perf, nodes));
+	else if (CountsPerfEvents()) output.Send(run + " perf counters could not be opened, see /proc/sys/kernel/perf_event_paranoid");
+}
+
+//bench [depth] [hash mb], not a uci command, the node count of the bench positions and the speed
+auto RunBench(info_sink& output, std::istringstream& input)
+{
+	auto depth = control::bench_depth;
+	auto hash_mb = control::hash_size_mb;
+	input >> depth >> hash_mb;
+	auto position = 0;
+	auto counting = OpenPerfCounters();
+	auto result = Bench(depth, hash_mb, [&](const std::string& fen, const search_info& info)
+		{
+			output.Send("bench position " + std::to_string(++position) + " nodes " + std::to_string(info.nodes) + " fen " + fen);
+		});
+	auto perf = ClosePerfCounters();
+	auto nps = (result.time > 0) ? static_cast<std::uint64_t>(result.nodes / result.time) : 0;
+	output.Send("bench nodes " + std::to_string(result.nodes) + " time " + std::to_string(static_cast<int>(result.time * 1000))
+		+ " nps " + std::to_string(nps));
+	SendPerf(output, "bench", counting, perf, result.nodes);
+}
+
+//trace start | stop [file], not a uci command, record a timeline of the searches and write it as chrome trace json
+auto Trace(info_sink& output, std::istringstream& input)
+{
+	auto action = std::string{};
+	auto path = std::string(control::trace_file);
+	input >> action >> path;
+	if (action == "start")
+	{
+		StartTrace();
+		output.Send("info string tracing");
+	}
+	else if (action == "stop")
+	{
+		output.Send(WriteTrace(path) ? "info string trace written to " + path : "info string trace not written, can not open " + path);
+	}
+}
+
+//perft [depth], not a uci command, the leaf boards of all moves of the position to a depth and the speed
+auto RunPerft(info_sink& output, const board& brd, int color, std::istringstream& input)
+{
+	auto depth = control::perft_depth;
+	input >> depth;
+	auto counting = OpenPerfCounters();
+	auto start = std::chrono::steady_clock::now();
+	StartPerfCounters();
+	auto nodes = Perft(brd, color, depth);
+	StopPerfCounters();
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+	auto perf = ClosePerfCounters();
+	auto nps = (elapsed.count() > 0) ? static_cast<std::uint64_t>(nodes / elapsed.count()) : 0;
+	output.Send("perft depth " + std::to_string(depth) + " nodes " + std::to_string(nodes) + " time "
+		+ std::to_string(static_cast<int>(elapsed.count() * 1000)) + " nps " + std::to_string(nps));
+	SendPerf(output, "perft", counting, perf, nodes);
+}
+
+//allocations of the bench searches after a first run to warm up, reported with the name of the check,
+//true if the search trees below the roots allocate no more per node than allowed
+auto CheckAllocations(info_sink& output, const std::string& name, int depth, double allowed)
+{
+	Bench(depth, control::hash_size_mb);
+	auto before = AllocationCount();
+	auto result = Bench(depth, control::hash_size_mb);
+	auto after = AllocationCount();
+	auto nodes = std::max<std::uint64_t>(result.nodes, 1);
+	auto per_node = double(result.tree_allocations) / nodes;
+	auto passed = per_node <= allowed;
+	output.Send(name + " nodes " + std::to_string(result.nodes) + " tree allocations " + std::to_string(result.tree_allocations)
+		+ " per node " + std::to_string(per_node) + ", search allocations " + std::to_string(after.allocations - before.allocations)
+		+ " bytes " + std::to_string(after.bytes - before.bytes) + (passed ? " passed" : " failed"));
+	return passed;
+}
+
+//alloccheck [depth] [allocations per node] [syzygy path], not a uci command, the allocations of the bench searches
+//after a first run to warm up, failing if the search trees below the roots allocate more per node than allowed, none by default,
+//the allocations of all the search, its root moves, lines and reports too, given alongside, only in allocation tracking builds,
+//checked again probing the tables of the path when one is given
+auto RunAllocationCheck(info_sink& output, std::istringstream& input)
+{
+	if (!TracksAllocations())
+	{
+		output.Send("allocation tracking is not built in, configure with -DCHESSTOGO_ALLOC_TRACKING=ON");
+		return 2;
+	}
+	auto depth = control::bench_depth;
+	auto allowed = 0.0;
+	auto path = std::string{};
+	input >> depth >> allowed >> path;
+	auto passed = CheckAllocations(output, "alloccheck", depth, allowed);
+	if (path.empty()) return passed ? 0 : 1;
+	auto pieces = SetTablebasePath(path);
+	if (pieces == 0)
+	{
+		output.Send("alloccheck no tablebases in " + path);
+		return 2;
+	}
+	passed = CheckAllocations(output, "alloccheck tablebases " + std::to_string(pieces) + " pieces", depth, allowed) && passed;
+	return passed ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	LoadNetwork(control::network_file);
+	LoadBook(control::book_file);
+	LoadExplorer(control::explorer_file);
+	auto uci = session{};
+	NameTraceThread("uci");
+	if (argc > 1 && std::string(argv[1]) == "bench")
+	{
+		//bench from the command line, the arguments after it as those of the command
+		auto arguments = std::string{};
+		for (auto index = 2; index < argc; ++index) arguments += std::string(argv[index]) + " ";
+		auto input = std::istringstream(arguments);
+		RunBench(uci.output, input);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "perft")
+	{
+		auto input = std::istringstream((argc > 2) ? argv[2] : "");
+		RunPerft(uci.output, uci.brd, uci.color, input);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "alloccheck")
+	{
+		auto arguments = std::string{};
+		for (auto index = 2; index < argc; ++index) arguments += std::string(argv[index]) + " ";
+		auto input = std::istringstream(arguments);
+		return RunAllocationCheck(uci.output, input);
+	}
+	auto line = std::string{};
+	while (std::getline(std::cin, line))
+	{
+		auto input = std::istringstream(line);
+		auto command = std::string{};
+		input >> command;
+		if (command == "uci")
+		{
+			uci.output.Send("id name ChessToGo");
+			uci.output.Send("id author tdarbinyan");
+			uci.output.Send("option name Hash type spin default " + std::to_string(control::hash_size_mb) + " min 1 max " + std::to_string(option::max_hash_mb));
+			uci.output.Send("option name Threads type spin default 1 min 1 max " + std::to_string(option::max_threads));
+			uci.output.Send("option name MultiPV type spin default 1 min 1 max " + std::to_string(option::max_multi_pv));
+			uci.output.Send("option name Ponder type check default false");
+			uci.output.Send(std::string("option name EvalFile type string default ") + control::network_file);
+			uci.output.Send("option name SyzygyPath type string default <empty>");
+			uci.output.Send(std::string("option name BookFile type string default ") + control::book_file);
+			uci.output.Send("option name BookVariety type spin default " + std::to_string(control::book_variety) + " min 0 max 100");
+			uci.output.Send(std::string("option name ExplorerFile type string default ") + control::explorer_file);
+			uci.output.Send("uciok");
+		}
+		else if (command == "isready") uci.output.Send("readyok");
+		else if (command == "setoption") SetOption(uci, input);
+		else if (command == "ucinewgame")
+		{
+			StopSearch(uci);
+			ClearHash();
+		}
+		else if (command == "position")
+		{
+			StopSearch(uci);
+			SetPosition(uci, input);
+		}
+		else if (command == "go") Go(uci, input);
+		else if (command == "stop") StopSearch(uci);
+		else if (command == "explore") Explore(uci);
+		else if (command == "bench")
+		{
+			//the bench leaves one thread and its own hash size
+			StopSearch(uci);
+			RunBench(uci.output, input);
+			SetHashSize(uci.hash_mb);
+			SetThreads(uci.threads);
+		}
+		else if (command == "perft")
+		{
+			StopSearch(uci);
+			RunPerft(uci.output, uci.brd, uci.color, input);
+		}
+		else if (command == "trace") Trace(uci.output, input);
+		else if (command == "fen") uci.output.Send("info string fen " + GetFen(uci.brd, uci.color));
+		else if (command == "ponderhit")
+		{
+			PonderHit(uci.ponder_time);
+			uci.wait_for_stop = false;
+		}
+		else if (command == "quit") break;
+	}
+	StopSearch(uci);
+	return 0;
+}